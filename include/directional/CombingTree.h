@@ -0,0 +1,109 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2021 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef DIRECTIONAL_COMBING_TREE_H
+#define DIRECTIONAL_COMBING_TREE_H
+
+#include <vector>
+#include <Eigen/Core>
+#include <igl/igl_inline.h>
+
+namespace directional
+{
+  // The dual spanning forest along which a field is combed (see directional::combing), stored as a traversal order.
+  // It only depends on the mesh and the cuts, so it is built once with set_tree(), and combing any field is then a single pass over the order, where every face takes its turn from its parent, which comes earlier.
+  // The forest is the breadth-first one of combing_face_turns(), so the turns are identical.
+  struct CombingTree{
+  public:
+
+    Eigen::VectorXi faces;          //#F the faces in traversal order (every tree starts at its root)
+    Eigen::VectorXi parentFaces;    //#F the parent of faces(i) (-1 for roots)
+    Eigen::VectorXi parentEdges;    //#F the edge crossed from the parent to faces(i) (-1 for roots)
+    Eigen::VectorXi edgeSigns;      //#F 1 if the parent is EF(parentEdges(i),0) (the matching is applied as is), -1 if it is inverted (0 for roots)
+
+    CombingTree(){}
+    ~CombingTree(){}
+
+    int num_faces() const {return faces.size();}
+
+    // Builds the forest.
+    // Input:
+    //  EF:         #E x 2 edges to faces indices
+    //  FE:         #F x 3 faces to edges indices
+    //  faceIsCut:  #F x 3 whether the edge FE(f,i) is cut (empty for no cuts)
+    IGL_INLINE void set_tree(const Eigen::MatrixXi& EF,
+                             const Eigen::MatrixXi& FE,
+                             const Eigen::MatrixXi& faceIsCut)
+    {
+      int numFaces=FE.rows();
+      faces.resize(numFaces);
+      parentFaces.resize(numFaces);
+      parentEdges.resize(numFaces);
+      edgeSigns.resize(numFaces);
+
+      //the queue holds (face, parent, edge) in the order of discovery; a face takes the first entry that reaches it
+      std::vector<char> visitedFaces(numFaces,0);
+      std::vector<int> queueFaces, queueParents, queueEdges;
+      queueFaces.reserve(numFaces);
+      int currIndex=0;
+      for (int seed=0;seed<numFaces;seed++){
+        if (visitedFaces[seed])
+          continue;
+        queueFaces.clear();
+        queueParents.clear();
+        queueEdges.clear();
+        queueFaces.push_back(seed);
+        queueParents.push_back(-1);
+        queueEdges.push_back(-1);
+        for (size_t q=0;q<queueFaces.size();q++){
+          int currFace=queueFaces[q];
+          if (visitedFaces[currFace])
+            continue;
+          visitedFaces[currFace]=1;
+
+          faces(currIndex)=currFace;
+          parentFaces(currIndex)=queueParents[q];
+          parentEdges(currIndex)=queueEdges[q];
+          edgeSigns(currIndex)=(queueEdges[q]==-1 ? 0 : (EF(queueEdges[q],0)==queueParents[q] ? 1 : -1));
+          currIndex++;
+
+          for (int i=0;i<3;i++){
+            int currEdge=FE(currFace,i);
+            int nextFace=(EF(currEdge,0)==currFace ? EF(currEdge,1) : EF(currEdge,0));
+            bool isCut=((faceIsCut.size()!=0)&&(faceIsCut(currFace,i)));
+            if ((nextFace!=-1)&&(!visitedFaces[nextFace])&&(!isCut)){
+              queueFaces.push_back(nextFace);
+              queueParents.push_back(currFace);
+              queueEdges.push_back(currEdge);
+            }
+          }
+        }
+      }
+    }
+
+    // The turn of every face (see directional::combing_face_turns()) for a given matching, by one pass over the traversal order.
+    // Input:
+    //  matching:   #E matching function
+    //  N:          The degree of the field.
+    // Output:
+    //  faceTurns:  #F turn of every face (0 for the roots)
+    IGL_INLINE void face_turns(const Eigen::VectorXi& matching,
+                               const int N,
+                               Eigen::VectorXi& faceTurns) const
+    {
+      faceTurns.resize(faces.size());
+      for (int i=0;i<faces.size();i++){
+        if (parentFaces(i)==-1)
+          faceTurns(faces(i))=0;
+        else
+          faceTurns(faces(i))=(faceTurns(parentFaces(i))+edgeSigns(i)*matching(parentEdges(i))+10*N)%N;  //killing negatives
+      }
+    }
+  };
+}
+
+#endif
@@ -0,0 +1,76 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2021 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef DIRECTIONAL_FIELD_BUNDLE_H
+#define DIRECTIONAL_FIELD_BUNDLE_H
+
+#include <cstdint>
+#include <cstring>
+#include <Eigen/Core>
+#include <igl/igl_inline.h>
+
+namespace directional
+{
+  // A processed directional field together with its derived quantities, stored in a single binary file by directional::write_field_bundle and read back by directional::read_field_bundle, so that downstream stages do not recompute them.
+  // Every member is optional: empty members are not written, and members whose chunks are missing (or were not requested) are read as empty.
+  //
+  // File layout (all in the byte order of the writing machine, identified by byteOrder):
+  //  Header (32 bytes), then a table of numChunks ChunkEntry (48 bytes each), then the chunk payloads, each starting at an 8-byte aligned offset.
+  //  Each payload is a column-major rows by cols matrix of int32 or double, with a CRC-32 (see directional::crc32) in its table entry, so that every chunk can be read and verified on its own.
+  //  Chunks with an unknown id are skipped by the reader.
+  struct FieldBundle{
+  public:
+
+    enum ChunkId{RAW_FIELD=1, MATCHING=2, EFFORT=3, SING_VERTICES=4, SING_INDICES=5, COMBED_FIELD=6, COMBED_MATCHING=7, FACE_IS_CUT=8};
+    enum ChunkType{CHUNK_INT32=0, CHUNK_DOUBLE=1};
+    static const unsigned int ALL_CHUNKS = ~0u;
+
+    struct Header{
+      char magic[8];              //"DIRBNDL1"
+      std::uint32_t version;      //format version (currently 1)
+      std::uint32_t byteOrder;    //0x01020304 as written by the producing machine
+      std::uint32_t N;            //degree of the field
+      std::uint32_t numChunks;
+      std::uint64_t reserved;
+
+      Header():version(1), byteOrder(0x01020304), N(0), numChunks(0), reserved(0){std::memcpy(magic, "DIRBNDL1", 8);}
+      bool is_valid() const {return (std::memcmp(magic, "DIRBNDL1", 8)==0) && (version==1) && (byteOrder==0x01020304);}
+    };
+
+    struct ChunkEntry{
+      std::uint32_t id;           //one of ChunkId
+      std::uint32_t type;         //one of ChunkType
+      std::uint64_t rows, cols;
+      std::uint64_t offset;       //byte offset of the payload from the beginning of the file
+      std::uint64_t size;         //payload size in bytes
+      std::uint32_t checksum;     //CRC-32 of the payload
+      std::uint32_t reserved;
+    };
+
+    int N;                            //The degree of the field
+    Eigen::MatrixXd rawField;         //#F by 3*N raw field (xyzxyz)
+    Eigen::VectorXi matching;         //#E matching (see directional::principal_matching)
+    Eigen::VectorXd effort;           //#E effort
+    Eigen::VectorXi singVertices;     //singular vertices
+    Eigen::VectorXi singIndices;      //their indices (the actual fractional index is singIndices/N)
+    Eigen::MatrixXd combedField;      //#F by 3*N combed raw field (see directional::combing)
+    Eigen::VectorXi combedMatching;   //#E matching of the combed field
+    Eigen::MatrixXi faceIsCut;        //#F by 3 seams: whether each face edge is cut (as in directional::cut_mesh_with_singularities)
+
+    FieldBundle():N(0){}
+    ~FieldBundle(){}
+
+    // The bit of a chunk in the chunkMask argument of directional::read_field_bundle.
+    static unsigned int chunk_bit(const ChunkId id){return 1u<<id;}
+  };
+
+  static_assert(sizeof(FieldBundle::Header)==32, "FieldBundle::Header must be exactly 32 bytes");
+  static_assert(sizeof(FieldBundle::ChunkEntry)==48, "FieldBundle::ChunkEntry must be exactly 48 bytes");
+  static_assert(sizeof(int)==4, "FieldBundle stores integers as 32 bits");
+}
+
+#endif
@@ -0,0 +1,140 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2021 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef DIRECTIONAL_MAPPED_RAW_FIELD_H
+#define DIRECTIONAL_MAPPED_RAW_FIELD_H
+
+#include <string>
+#include <cstring>
+#include <cassert>
+#include <type_traits>
+#include <Eigen/Core>
+#include <igl/igl_inline.h>
+#include <directional/RawFieldHeader.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace directional
+{
+  // A read-only memory mapping of a binary raw field file (see directional::RawFieldHeader and directional::write_raw_field_binary).
+  // The payload is exposed as an Eigen::Map without copying or parsing; pages are loaded by the OS on first access, and are shared between processes that map the same file.
+  // The maps returned by map() are valid until close() is called or the object is destroyed.
+  struct MappedRawField{
+  public:
+
+    RawFieldHeader header;
+
+    MappedRawField():data(NULL), size(0){init_handles();}
+    MappedRawField(const std::string& fileName):data(NULL), size(0){init_handles(); open(fileName);}
+    ~MappedRawField(){close();}
+
+    //the mapping owns OS resources
+    MappedRawField(const MappedRawField&) = delete;
+    MappedRawField& operator=(const MappedRawField&) = delete;
+
+    bool is_open() const {return data!=NULL;}
+    int N() const {return header.N;}
+    int num_faces() const {return header.numFaces;}
+    bool is_float() const {return header.scalarType==RawFieldHeader::SCALAR_FLOAT;}
+    bool is_row_major() const {return header.layout==RawFieldHeader::ROW_MAJOR;}
+
+    // Maps a file. Returns false (and leaves the object closed) if the file cannot be mapped, its header is invalid, or it is shorter than the header announces.
+    IGL_INLINE bool open(const std::string& fileName)
+    {
+      close();
+#ifdef _WIN32
+      file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+      if (file==INVALID_HANDLE_VALUE)
+        return false;
+      LARGE_INTEGER fileSize;
+      if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart<(LONGLONG)sizeof(RawFieldHeader)){
+        close();
+        return false;
+      }
+      size = fileSize.QuadPart;
+      mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+      if (mapping==NULL){
+        close();
+        return false;
+      }
+      data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+      if (data==NULL){
+        close();
+        return false;
+      }
+#else
+      int fd = ::open(fileName.c_str(), O_RDONLY);
+      if (fd<0)
+        return false;
+      struct stat fileStat;
+      if ((fstat(fd, &fileStat)!=0) || (fileStat.st_size<(off_t)sizeof(RawFieldHeader))){
+        ::close(fd);
+        return false;
+      }
+      size = fileStat.st_size;
+      void* address = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+      ::close(fd);  //the mapping keeps its own reference to the file
+      if (address==MAP_FAILED)
+        return false;
+      data = static_cast<const char*>(address);
+#endif
+      header = *reinterpret_cast<const RawFieldHeader*>(data);  //mappings are page-aligned
+      if (!header.is_valid() || (!header.fits_in(size))){
+        close();
+        return false;
+      }
+      return true;
+    }
+
+    // Unmaps the file; all maps obtained from this object become invalid.
+    IGL_INLINE void close()
+    {
+#ifdef _WIN32
+      if (data!=NULL) UnmapViewOfFile(data);
+      if (mapping!=NULL) CloseHandle(mapping);
+      if (file!=INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+      if (data!=NULL) munmap(const_cast<char*>(data), size);
+#endif
+      data=NULL;
+      size=0;
+      init_handles();
+    }
+
+    // The #F by 3*N raw field (xyzxyz) in place. Scalar and Options must match the file (see is_float() and is_row_major()); e.g., map<double>() for a column-major double file is an Eigen::Map<const Eigen::MatrixXd>.
+    template<typename Scalar, int Options=Eigen::ColMajor>
+    Eigen::Map<const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Options> > map() const
+    {
+      assert(is_open() && "MappedRawField::map(): no file is mapped");
+      assert((is_float()==std::is_same<Scalar,float>::value) && "MappedRawField::map(): the scalar type does not match the file");
+      assert((is_row_major()==((Options & Eigen::RowMajor)!=0)) && "MappedRawField::map(): the layout does not match the file");
+      return Eigen::Map<const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Options> >(reinterpret_cast<const Scalar*>(data+header.payloadOffset), header.numFaces, 3*header.N);
+    }
+
+  private:
+    const char* data;         //the start of the mapped file
+    std::uint64_t size;       //the size of the mapped file in bytes
+#ifdef _WIN32
+    HANDLE file, mapping;
+    void init_handles(){file=INVALID_HANDLE_VALUE; mapping=NULL;}
+#else
+    void init_handles(){}
+#endif
+  };
+}
+
+#endif
@@ -0,0 +1,100 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2021 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef DIRECTIONAL_MESH_TOPOLOGY_H
+#define DIRECTIONAL_MESH_TOPOLOGY_H
+
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+#include <igl/igl_inline.h>
+#include <igl/edge_topology.h>
+#include <igl/triangle_triangle_adjacency.h>
+#include <igl/local_basis.h>
+#include <igl/doublearea.h>
+#include <igl/boundary_loop.h>
+#include <directional/dual_cycles.h>
+#include <directional/SingularityDetector.h>
+#include <directional/edge_transport.h>
+#include <directional/face_components.h>
+#include <directional/CombingTree.h>
+
+namespace directional
+{
+  // The field-independent quantities of a triangle mesh that are needed by most of the pipeline (matching, combing, streamlines, field design, integration).
+  // It is built once per mesh with set_mesh(), and then passed to the overloads that take a MeshTopology instead of recomputing the adjacency relations, bases, and dual cycles from V and F on every call.
+  struct MeshTopology{
+  public:
+
+    Eigen::MatrixXd V;              //#V by 3 vertex coordinates
+    Eigen::MatrixXi F;              //#F by 3 face vertex indices
+
+    Eigen::MatrixXi EV;             //#E by 2 edges to vertices indices
+    Eigen::MatrixXi FE;             //#F by 3 faces to edges indices
+    Eigen::MatrixXi EF;             //#E by 2 edges to faces indices
+    Eigen::MatrixXi TT, TTi;        //#F by 3 triangle-triangle adjacency (as in igl::triangle_triangle_adjacency)
+
+    Eigen::MatrixXd B1, B2;         //#F by 3 local basis of each face
+    Eigen::MatrixXd FN;             //#F by 3 face normals (the third local basis vector)
+    Eigen::VectorXd faceAreas;      //#F face areas
+    Eigen::MatrixXd edgeVectors;    //#E by 3 normalized edge vectors
+    Eigen::VectorXcd edgeTransport; //#E transport of complex face coordinates across each edge (see directional::edge_transport)
+
+    std::vector<std::vector<int> > boundaryLoops;  //as in igl::boundary_loop
+    Eigen::VectorXi isBoundaryVertex;              //#V 1 if the vertex is on the boundary, 0 otherwise
+
+    int numComponents;                             //number of connected components (faces connected through inner edges)
+    Eigen::VectorXi faceComponents;                //#F the component of every face (see directional::face_components)
+    mutable CombingTree combingTree;               //Dual spanning forest for combing without cuts (see directional::CombingTree); built on first use by combing_tree()
+
+    SingularityDetector singularityDetector;       //Dual cycles and their curvature (see directional::dual_cycles)
+
+    MeshTopology():numComponents(0){}
+    MeshTopology(const Eigen::MatrixXd& _V, const Eigen::MatrixXi& _F){set_mesh(_V,_F);}
+    ~MeshTopology(){}
+
+    // Computes all the topological and geometric quantities of the mesh. Must be called again whenever V or F change.
+    IGL_INLINE void set_mesh(const Eigen::MatrixXd& _V, const Eigen::MatrixXi& _F)
+    {
+      V=_V;
+      F=_F;
+      igl::edge_topology(V, F, EV, FE, EF);
+      igl::triangle_triangle_adjacency(F, TT, TTi);
+      igl::local_basis(V, F, B1, B2, FN);
+      edge_transport(V, EV, EF, B1, B2, edgeVectors, edgeTransport);
+
+      Eigen::VectorXd doubleAreas;
+      igl::doublearea(V, F, doubleAreas);
+      faceAreas=doubleAreas/2.0;
+
+      igl::boundary_loop(F, boundaryLoops);
+      isBoundaryVertex=Eigen::VectorXi::Zero(V.rows());
+      for (size_t i=0;i<boundaryLoops.size();i++)
+        for (size_t j=0;j<boundaryLoops[i].size();j++)
+          isBoundaryVertex(boundaryLoops[i][j])=1;
+
+      numComponents=face_components(EF, F.rows(), faceComponents);
+      combingTree=CombingTree();
+
+      Eigen::SparseMatrix<double> basisCycles;
+      Eigen::VectorXd cycleCurvature;
+      Eigen::VectorXi vertex2cycle, innerEdges;
+      dual_cycles(V, F, EV, EF, basisCycles, cycleCurvature, vertex2cycle, innerEdges);
+      singularityDetector.set_cycles(EV.rows(), basisCycles, cycleCurvature, vertex2cycle, innerEdges, isBoundaryVertex);
+    }
+    
+    // The combing tree without cuts, which is built on the first call (not thread safe; call it once before combing concurrently).
+    IGL_INLINE const CombingTree& combing_tree() const
+    {
+      if (combingTree.num_faces()!=F.rows())
+        combingTree.set_tree(EF, FE, Eigen::MatrixXi());
+      return combingTree;
+    }
+  };
+}
+
+#endif
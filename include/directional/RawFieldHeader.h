@@ -0,0 +1,69 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2021 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef DIRECTIONAL_RAW_FIELD_HEADER_H
+#define DIRECTIONAL_RAW_FIELD_HEADER_H
+
+#include <cstdint>
+#include <cstring>
+#include <igl/igl_inline.h>
+
+namespace directional
+{
+  // The fixed 64-byte header of a binary raw field file. It is followed (at payloadOffset) by the #F by 3*N raw field (xyzxyz per face) as one contiguous array, so that the payload can be memory-mapped and wrapped by an Eigen::Map without copying (see directional::MappedRawField).
+  // Everything is stored in the byte order of the writing machine, which is identified by byteOrder.
+  struct RawFieldHeader{
+  public:
+
+    enum ScalarType{SCALAR_DOUBLE=0, SCALAR_FLOAT=1};
+    enum Layout{COLUMN_MAJOR=0, ROW_MAJOR=1};   //COLUMN_MAJOR is the layout of Eigen::MatrixXd; ROW_MAJOR keeps each face contiguous
+
+    char magic[8];              //"DIRFIELD"
+    std::uint32_t version;      //format version (currently 1)
+    std::uint32_t byteOrder;    //0x01020304 as written by the producing machine
+    std::uint32_t N;            //degree of the field
+    std::uint32_t scalarType;   //one of ScalarType
+    std::uint32_t layout;       //one of Layout
+    std::uint32_t reserved0;
+    std::uint64_t numFaces;     //#F
+    std::uint64_t payloadOffset;  //byte offset of the payload from the beginning of the file (a multiple of 8)
+    std::uint8_t reserved1[16];
+
+    RawFieldHeader():version(1), byteOrder(0x01020304), N(0), scalarType(SCALAR_DOUBLE), layout(COLUMN_MAJOR), reserved0(0), numFaces(0), payloadOffset(sizeof(RawFieldHeader))
+    {
+      std::memcpy(magic, "DIRFIELD", 8);
+      std::memset(reserved1, 0, sizeof(reserved1));
+    }
+    ~RawFieldHeader(){}
+
+    IGL_INLINE std::uint64_t scalar_size() const {return (scalarType==SCALAR_FLOAT ? sizeof(float) : sizeof(double));}
+    IGL_INLINE std::uint64_t payload_size() const {return numFaces*3*N*scalar_size();}
+
+    // Whether the payload lies within a file of fileSize bytes (without overflowing on corrupt sizes).
+    IGL_INLINE bool fits_in(const std::uint64_t fileSize) const
+    {
+      if (payloadOffset>fileSize)
+        return false;
+      std::uint64_t faceSize=3*std::uint64_t(N)*scalar_size();
+      if ((faceSize!=0)&&(numFaces>(fileSize-payloadOffset)/faceSize))
+        return false;
+      return true;
+    }
+
+    // Whether the header was produced by a compatible writer (magic, version, byte order, and known enumerations).
+    IGL_INLINE bool is_valid() const
+    {
+      return (std::memcmp(magic, "DIRFIELD", 8)==0) && (version==1) && (byteOrder==0x01020304) &&
+             ((scalarType==SCALAR_DOUBLE)||(scalarType==SCALAR_FLOAT)) && ((layout==COLUMN_MAJOR)||(layout==ROW_MAJOR)) &&
+             (payloadOffset>=sizeof(RawFieldHeader)) && (payloadOffset%8==0);
+    }
+  };
+
+  static_assert(sizeof(RawFieldHeader)==64, "RawFieldHeader must be exactly 64 bytes");
+}
+
+#endif
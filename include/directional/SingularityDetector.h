@@ -0,0 +1,84 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2021 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef DIRECTIONAL_SINGULARITY_DETECTOR_H
+#define DIRECTIONAL_SINGULARITY_DETECTOR_H
+
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+#include <igl/igl_inline.h>
+#include <igl/boundary_loop.h>
+#include <directional/dual_cycles.h>
+
+namespace directional
+{
+  // The mesh-dependent part of singularity detection (see directional::effort_to_indices): the dual-cycle basis, its curvature, and the boundary mask.
+  // The cycles are stored against all #E edges (rather than only the inner edges as in directional::dual_cycles), so that the indices of a field are a single sparse product with its effort, followed by rounding.
+  struct SingularityDetector{
+  public:
+
+    Eigen::SparseMatrix<double> basisCycles;  //#c by #E basis cycles (zero columns for non-inner edges)
+    Eigen::VectorXd cycleCurvature;           //#c curvatures of each cycle
+    Eigen::VectorXi vertex2cycle;             //#V map between vertex and corresponding cycle
+    Eigen::VectorXi innerEdges;               //#iE the inner edges (as given by directional::dual_cycles)
+    Eigen::VectorXi isBoundaryVertex;         //#V 1 if the vertex is on the boundary, 0 otherwise
+
+    SingularityDetector(){}
+    ~SingularityDetector(){}
+
+    // Sets the detector from dual cycles that were already computed by directional::dual_cycles.
+    // Input:
+    //  numEdges:     #E the total number of edges
+    //  _basisCycles: #c by #iE basis cycles
+    //  others as the respective fields.
+    IGL_INLINE void set_cycles(const int numEdges,
+                               const Eigen::SparseMatrix<double>& _basisCycles,
+                               const Eigen::VectorXd& _cycleCurvature,
+                               const Eigen::VectorXi& _vertex2cycle,
+                               const Eigen::VectorXi& _innerEdges,
+                               const Eigen::VectorXi& _isBoundaryVertex)
+    {
+      using namespace Eigen;
+      cycleCurvature=_cycleCurvature;
+      vertex2cycle=_vertex2cycle;
+      innerEdges=_innerEdges;
+      isBoundaryVertex=_isBoundaryVertex;
+
+      //spreading the inner-edge columns into the full edge range
+      std::vector<Triplet<double> > scatterTriplets;
+      for (int i=0;i<innerEdges.size();i++)
+        scatterTriplets.push_back(Triplet<double>(i, innerEdges(i), 1.0));
+      SparseMatrix<double> scatterMat(innerEdges.size(), numEdges);
+      scatterMat.setFromTriplets(scatterTriplets.begin(), scatterTriplets.end());
+      basisCycles=_basisCycles*scatterMat;
+    }
+
+    // Computes the dual cycles and boundary mask of the mesh. Must be called again whenever the mesh changes.
+    IGL_INLINE void set_mesh(const Eigen::MatrixXd& V,
+                             const Eigen::MatrixXi& F,
+                             const Eigen::MatrixXi& EV,
+                             const Eigen::MatrixXi& EF)
+    {
+      Eigen::SparseMatrix<double> _basisCycles;
+      Eigen::VectorXd _cycleCurvature;
+      Eigen::VectorXi _vertex2cycle, _innerEdges;
+      dual_cycles(V, F, EV, EF, _basisCycles, _cycleCurvature, _vertex2cycle, _innerEdges);
+
+      std::vector<std::vector<int> > boundaryLoops;
+      igl::boundary_loop(F, boundaryLoops);
+      Eigen::VectorXi _isBoundaryVertex=Eigen::VectorXi::Zero(V.rows());
+      for (size_t i=0;i<boundaryLoops.size();i++)
+        for (size_t j=0;j<boundaryLoops[i].size();j++)
+          _isBoundaryVertex(boundaryLoops[i][j])=1;
+
+      set_cycles(EV.rows(), _basisCycles, _cycleCurvature, _vertex2cycle, _innerEdges, _isBoundaryVertex);
+    }
+  };
+}
+
+#endif
@@ -0,0 +1,86 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2021 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef DIRECTIONAL_TANGENT_FIELD_H
+#define DIRECTIONAL_TANGENT_FIELD_H
+
+#include <complex>
+#include <Eigen/Core>
+#include <igl/igl_inline.h>
+#include <igl/parallel_for.h>
+
+namespace directional
+{
+  // A face-based directional field stored by the complex coordinates of its N vectors in the local basis (B1,B2) of each face, instead of the xyzxyz raw format.
+  // The storage is #F by N column-major, so that each vector index is a contiguous array over the faces (structure of arrays). It takes 2N instead of 3N scalars per face, and the kernels that work in the local bases (matching, combing, root extraction) read it without projecting.
+  // The vectors of each face are assumed to be ordered CCW, as in the raw format.
+  // Scalar is the precision of the storage: TangentFieldf halves the memory of TangentField, which is enough for visualization and coarse design. The raw input and output (and the bases) are always in double.
+  template<typename Scalar>
+  struct TangentFieldT{
+  public:
+
+    typedef std::complex<Scalar> Complex;
+    typedef Eigen::Matrix<Complex, Eigen::Dynamic, Eigen::Dynamic> MatrixXc;
+
+    MatrixXc field;   //#F by N complex coordinates (vector j of face f is B1.row(f)*real(field(f,j))+B2.row(f)*imag(field(f,j)))
+
+    TangentFieldT(){}
+    TangentFieldT(const int numFaces, const int N){field=MatrixXc::Zero(numFaces, N);}
+    TangentFieldT(const Eigen::MatrixXd& B1, const Eigen::MatrixXd& B2, const Eigen::MatrixXd& rawField){set_raw(B1, B2, rawField);}
+    ~TangentFieldT(){}
+
+    int N() const {return field.cols();}
+    int num_faces() const {return field.rows();}
+
+    // Views (no copies) of all the faces' j-th vector, and of all vectors of face f.
+    typename MatrixXc::ColXpr vectors(const int j){return field.col(j);}
+    typename MatrixXc::ConstColXpr vectors(const int j) const {return field.col(j);}
+    typename MatrixXc::RowXpr face(const int f){return field.row(f);}
+    typename MatrixXc::ConstRowXpr face(const int f) const {return field.row(f);}
+
+    // The same field in another precision.
+    template<typename OtherScalar>
+    TangentFieldT<OtherScalar> cast() const
+    {
+      TangentFieldT<OtherScalar> other;
+      other.field=field.template cast<std::complex<OtherScalar> >();
+      return other;
+    }
+
+    // Projects a raw field (#F by 3*N, xyzxyz) onto the local bases. The normal components are dropped.
+    IGL_INLINE void set_raw(const Eigen::MatrixXd& B1,
+                            const Eigen::MatrixXd& B2,
+                            const Eigen::MatrixXd& rawField)
+    {
+      int N=rawField.cols()/3;
+      field.resize(rawField.rows(), N);
+      igl::parallel_for(rawField.rows(), [&](const int f){
+        for (int j=0;j<N;j++){
+          Eigen::RowVector3d vec = rawField.block<1,3>(f, 3*j);
+          field(f,j) = Complex(vec.dot(B1.row(f)), vec.dot(B2.row(f)));
+        }
+      }, 1000);
+    }
+
+    // Expands the field to the raw format (#F by 3*N, xyzxyz).
+    IGL_INLINE void get_raw(const Eigen::MatrixXd& B1,
+                            const Eigen::MatrixXd& B2,
+                            Eigen::MatrixXd& rawField) const
+    {
+      rawField.resize(field.rows(), 3*field.cols());
+      igl::parallel_for(field.rows(), [&](const int f){
+        for (int j=0;j<field.cols();j++)
+          rawField.block<1,3>(f, 3*j) = B1.row(f)*(double)field(f,j).real() + B2.row(f)*(double)field(f,j).imag();
+      }, 1000);
+    }
+  };
+
+  typedef TangentFieldT<double> TangentField;
+  typedef TangentFieldT<float> TangentFieldf;
+}
+
+#endif
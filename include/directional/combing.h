@@ -18,40 +18,83 @@
 #include <igl/local_basis.h>
 #include <igl/triangle_triangle_adjacency.h>
 #include <igl/edge_topology.h>
+#include <igl/parallel_for.h>
 #include <directional/tree.h>
 #include <directional/representative_to_raw.h>
 #include <directional/principal_matching.h>
+#include <directional/MeshTopology.h>
+#include <directional/face_components.h>
+#include <directional/CombingTree.h>
+#include <directional/TangentField.h>
 
 namespace directional
 {
-  // Reorders the vectors in a face (preserving CCW) so that the prescribed matching across most edges, except a small set (called a cut), is an identity, making it ready for cutting and parameterization.
-  // Important: if the Raw field in not CCW ordered, the result is unpredictable.
+  // Rotates the vectors of each face so that vector faceTurns(f) comes first (the combed vector j is the original vector (j+faceTurns(f))%N), for a degree NT that is known at compile time.
+  // NT=Eigen::Dynamic is the generic version for any degree N.
+  template<int NT>
+  IGL_INLINE void combing_apply_turns_degree(const Eigen::MatrixXd& rawField,
+                                             const Eigen::VectorXi& faceTurns,
+                                             const int N,
+                                             Eigen::MatrixXd& combedField)
+  {
+    const int n = (NT==Eigen::Dynamic ? N : NT);
+    combedField.resize(rawField.rows(), rawField.cols());
+    for (int f=0;f<rawField.rows();f++)
+      for (int j=0;j<n;j++)
+        combedField.block<1,3>(f, 3*j)=rawField.block<1,3>(f, 3*((j+faceTurns(f))%n));
+  }
+  
+  // Rotates the vectors of each face by faceTurns (see combing_apply_turns_degree()), dispatching to a fixed-degree version when possible.
   // Input:
-  //  V:        #V x 3 vertex coordinates
-  //  F:        #F x 3 face vertex indices
-  //  EV:       #E x 2 edges to vertices indices
-  //  EF:       #E x 2 edges to faces indices
-  //  rawField: #F by 3*N  The directional field, assumed to be ordered CCW, and in xyzxyz raw format. The degree is inferred by the size.
-  //  matching: #E matching function, where vector k in EF(i,0) matches to vector (k+matching(k))%N in EF(i,1). In case of boundary, there is a -1.
+  //  rawField:   #F by 3*N  The directional field in xyzxyz raw format.
+  //  faceTurns:  #F in [0,N) the index of the vector that becomes the first one in every face.
   // Output:
   //  combedField: #F by 3*N reindexed field
-  IGL_INLINE void combing(const Eigen::MatrixXd& V,
-                          const Eigen::MatrixXi& F,
-                          const Eigen::MatrixXi& EV,
-                          const Eigen::MatrixXi& EF,
-                          const Eigen::MatrixXi& FE,
-                          const Eigen::MatrixXd& rawField,
-                          const Eigen::VectorXi& matching,
-                          Eigen::MatrixXd& combedField)
+  IGL_INLINE void combing_apply_turns(const Eigen::MatrixXd& rawField,
+                                      const Eigen::VectorXi& faceTurns,
+                                      Eigen::MatrixXd& combedField)
   {
-    using namespace Eigen;
-    //flood-filling through the matching to comb field
-    combedField.conservativeResize(rawField.rows(), rawField.cols());
     int N=rawField.cols()/3;
-    //dual tree to find combing routes
-    VectorXi visitedFaces=VectorXi::Constant(F.rows(),1,0);
+    switch (N){
+      case 1: combing_apply_turns_degree<1>(rawField, faceTurns, N, combedField); break;
+      case 2: combing_apply_turns_degree<2>(rawField, faceTurns, N, combedField); break;
+      case 4: combing_apply_turns_degree<4>(rawField, faceTurns, N, combedField); break;
+      case 6: combing_apply_turns_degree<6>(rawField, faceTurns, N, combedField); break;
+      default: combing_apply_turns_degree<Eigen::Dynamic>(rawField, faceTurns, N, combedField);
+    }
+  }
+  
+  
+  // Rotates the vectors of each face of a field in tangent form by faceTurns (see combing_apply_turns_degree()).
+  IGL_INLINE void combing_apply_turns(const TangentField& tangentField,
+                                      const Eigen::VectorXi& faceTurns,
+                                      TangentField& combedField)
+  {
+    int N=tangentField.N();
+    combedField.field.resize(tangentField.num_faces(), N);
+    for (int j=0;j<N;j++)
+      for (int f=0;f<tangentField.num_faces();f++)
+        combedField.field(f,j)=tangentField.field(f,(j+faceTurns(f))%N);
+  }
+  
+  // Flood-fills the matching from a seed face (which gets turn 0) along a dual spanning tree, not crossing cut edges or entering faces that are already visited.
+  // Input:
+  //  EF, FE, faceIsCut, matching, N: as in combing_face_turns()
+  //  seed:         the face to start from
+  // Output:
+  //  visitedFaces: #F marks the faces that are reached
+  //  faceTurns:    #F turn of every face that is reached
+  IGL_INLINE void combing_face_turns_from(const Eigen::MatrixXi& EF,
+                                          const Eigen::MatrixXi& FE,
+                                          const Eigen::MatrixXi& faceIsCut,
+                                          const Eigen::VectorXi& matching,
+                                          const int N,
+                                          const int seed,
+                                          Eigen::VectorXi& visitedFaces,
+                                          Eigen::VectorXi& faceTurns)
+  {
     std::queue<std::pair<int,int> > faceMatchingQueue;
-    faceMatchingQueue.push(std::pair<int,int>(0,0));
+    faceMatchingQueue.push(std::pair<int,int>(seed,0));
     do{
       std::pair<int,int> currFaceMatching=faceMatchingQueue.front();
       faceMatchingQueue.pop();
@@ -60,15 +103,15 @@ namespace directional
       visitedFaces(currFaceMatching.first)=1;
       
       //combing field to start from the matching index
-      combedField.block(currFaceMatching.first, 0, 1, 3*(N-currFaceMatching.second))=rawField.block(currFaceMatching.first, 3*currFaceMatching.second, 1, 3*(N-currFaceMatching.second));
-      combedField.block(currFaceMatching.first, 3*(N-currFaceMatching.second), 1, 3*currFaceMatching.second)=rawField.block(currFaceMatching.first, 0, 1, 3*currFaceMatching.second);
+      faceTurns(currFaceMatching.first)=currFaceMatching.second;
       
       for (int i=0;i<3;i++){
         int nextMatching=(matching(FE(currFaceMatching.first,i)));
         int nextFace=(EF(FE(currFaceMatching.first,i),0)==currFaceMatching.first ? EF(FE(currFaceMatching.first,i),1) : EF(FE(currFaceMatching.first,i),0));
         nextMatching*=(EF(FE(currFaceMatching.first,i),0)==currFaceMatching.first ? 1.0 : -1.0);
         nextMatching=(nextMatching+currFaceMatching.second+10*N)%N;  //killing negatives
-        if ((nextFace!=-1)&&(!visitedFaces(nextFace)))
+        bool isCut=((faceIsCut.size()!=0)&&(faceIsCut(currFaceMatching.first,i)));
+        if ((nextFace!=-1)&&(!visitedFaces(nextFace))&&(!isCut))
           faceMatchingQueue.push(std::pair<int,int>(nextFace, nextMatching));
         
       }
@@ -76,6 +119,135 @@ namespace directional
     }while (!faceMatchingQueue.empty());
   }
   
+  // Computes the turn of every face (the index of the vector that becomes the first one) by flood-filling the matching along a dual spanning tree, not crossing cut edges.
+  // The fill starts from face 0, and from the first face that is not yet reached whenever the previous fill ends, so every connected component (and every part that the cuts separate) is combed.
+  // The traversal does not depend on the matching; to comb several fields with the same cuts, build a directional::CombingTree once and replay it.
+  // Input:
+  //  EF:         #E x 2 edges to faces indices
+  //  FE:         #F x 3 faces to edges indices
+  //  faceIsCut:  #F x 3 whether the edge FE(f,i) is cut (empty for no cuts)
+  //  matching:   #E matching function
+  //  N:          The degree of the field.
+  // Output:
+  //  faceTurns:  #F turn of every face (0 for the first face of every part)
+  IGL_INLINE void combing_face_turns(const Eigen::MatrixXi& EF,
+                                     const Eigen::MatrixXi& FE,
+                                     const Eigen::MatrixXi& faceIsCut,
+                                     const Eigen::VectorXi& matching,
+                                     const int N,
+                                     Eigen::VectorXi& faceTurns)
+  {
+    using namespace Eigen;
+    VectorXi visitedFaces=VectorXi::Constant(FE.rows(),1,0);
+    faceTurns=VectorXi::Zero(FE.rows());
+    for (int i=0;i<FE.rows();i++)
+      if (!visitedFaces(i))
+        combing_face_turns_from(EF, FE, faceIsCut, matching, N, i, visitedFaces, faceTurns);
+  }
+  
+  // Version with precomputed connected components (see directional::face_components), where the components are combed in parallel. The result is identical to the serial version.
+  //  faceComponents: #F the component of every face
+  //  numComponents:  the number of components
+  IGL_INLINE void combing_face_turns(const Eigen::MatrixXi& EF,
+                                     const Eigen::MatrixXi& FE,
+                                     const Eigen::MatrixXi& faceIsCut,
+                                     const Eigen::VectorXi& matching,
+                                     const int N,
+                                     const Eigen::VectorXi& faceComponents,
+                                     const int numComponents,
+                                     Eigen::VectorXi& faceTurns)
+  {
+    using namespace Eigen;
+    if (numComponents<2){
+      combing_face_turns(EF, FE, faceIsCut, matching, N, faceTurns);
+      return;
+    }
+    
+    VectorXi visitedFaces=VectorXi::Constant(FE.rows(),1,0);
+    faceTurns=VectorXi::Zero(FE.rows());
+    VectorXi componentSeeds;
+    component_seeds(faceComponents, numComponents, componentSeeds);
+    //fills never leave their component, so they write to disjoint faces
+    igl::parallel_for(numComponents, [&](const int c){
+      combing_face_turns_from(EF, FE, faceIsCut, matching, N, componentSeeds(c), visitedFaces, faceTurns);
+    }, 1);
+    
+    //parts of components that are separated from their first face by cuts
+    for (int i=0;i<FE.rows();i++)
+      if (!visitedFaces(i))
+        combing_face_turns_from(EF, FE, faceIsCut, matching, N, i, visitedFaces, faceTurns);
+  }
+  
+  // Computes the matching of the combed field from the original matching and the face turns.
+  IGL_INLINE void combing_matching(const Eigen::MatrixXi& EF,
+                                   const Eigen::VectorXi& matching,
+                                   const Eigen::VectorXi& faceTurns,
+                                   const int N,
+                                   Eigen::VectorXi& combedMatching)
+  {
+    combedMatching.conservativeResize(EF.rows());
+    for (int i=0;i<EF.rows();i++){
+      if ((EF(i,0)==-1)||(EF(i,1)==-1))
+        combedMatching(i)=-1;
+      else
+        combedMatching(i)=(faceTurns(EF(i,0))-faceTurns(EF(i,1))+matching(i)+1000000*N)%N;
+    }
+  }
+  
+  
+  // A combed field that is not copied: the original raw field, the turn of every face, and the matching of the combed field.
+  // Combed vector j of face f is the original vector (j+faceTurns(f))%N, so the view costs an integer per face instead of a #F by 3N copy, and materialize() makes the copy only where one is needed.
+  // The view refers to the original raw field, which must outlive it.
+  struct CombedFieldView{
+  public:
+    
+    const Eigen::MatrixXd* rawField;  //#F by 3*N the original field
+    Eigen::VectorXi faceTurns;        //#F the original index of combed vector 0 in every face
+    Eigen::VectorXi combedMatching;   //#E matching of the combed field (-1 on the boundary)
+    
+    CombedFieldView():rawField(NULL){}
+    CombedFieldView(const Eigen::MatrixXd& _rawField):rawField(&_rawField){}
+    ~CombedFieldView(){}
+    
+    int N() const {return rawField->cols()/3;}
+    int num_faces() const {return rawField->rows();}
+    
+    // The original index of combed vector j of face f
+    int original_index(const int f, const int j) const {return (j+faceTurns(f))%N();}
+    
+    // Combed vector j of face f (a view into the original field)
+    Eigen::MatrixXd::ConstFixedBlockXpr<1,3>::Type vector(const int f, const int j) const {return rawField->block<1,3>(f, 3*original_index(f,j));}
+    
+    // The combed field as a #F by 3*N raw field
+    IGL_INLINE void materialize(Eigen::MatrixXd& combedField) const {combing_apply_turns(*rawField, faceTurns, combedField);}
+  };
+  
+  
+  // Reorders the vectors in a face (preserving CCW) so that the prescribed matching across most edges, except a small set (called a cut), is an identity, making it ready for cutting and parameterization.
+  // Important: if the Raw field in not CCW ordered, the result is unpredictable.
+  // Input:
+  //  V:        #V x 3 vertex coordinates
+  //  F:        #F x 3 face vertex indices
+  //  EV:       #E x 2 edges to vertices indices
+  //  EF:       #E x 2 edges to faces indices
+  //  rawField: #F by 3*N  The directional field, assumed to be ordered CCW, and in xyzxyz raw format. The degree is inferred by the size.
+  //  matching: #E matching function, where vector k in EF(i,0) matches to vector (k+matching(k))%N in EF(i,1). In case of boundary, there is a -1.
+  // Output:
+  //  combedField: #F by 3*N reindexed field
+  IGL_INLINE void combing(const Eigen::MatrixXd& V,
+                          const Eigen::MatrixXi& F,
+                          const Eigen::MatrixXi& EV,
+                          const Eigen::MatrixXi& EF,
+                          const Eigen::MatrixXi& FE,
+                          const Eigen::MatrixXd& rawField,
+                          const Eigen::VectorXi& matching,
+                          Eigen::MatrixXd& combedField)
+  {
+    Eigen::VectorXi faceTurns;
+    combing_face_turns(EF, FE, Eigen::MatrixXi(), matching, rawField.cols()/3, faceTurns);
+    combing_apply_turns(rawField, faceTurns, combedField);
+  }
+  
   //version for input in representative format (for N-RoSy directionals).
   IGL_INLINE void combing(const Eigen::MatrixXd& V,
                           const Eigen::MatrixXi& F,
@@ -104,48 +276,123 @@ namespace directional
                           Eigen::MatrixXd& combedField,
                           Eigen::VectorXi& combedMatching)
   {
-    using namespace Eigen;
-    //flood-filling through the matching to comb field
-    combedField.conservativeResize(rawField.rows(), rawField.cols());
-    combedMatching.conservativeResize(EF.rows());
     int N=rawField.cols()/3;
-    //dual tree to find combing routes
-    VectorXi visitedFaces=VectorXi::Constant(F.rows(),1,0);
-    std::queue<std::pair<int,int> > faceMatchingQueue;
-    faceMatchingQueue.push(std::pair<int,int>(0,0));
-    VectorXi faceTurns(rawField.rows());
-    do{
-      std::pair<int,int> currFaceMatching=faceMatchingQueue.front();
-      faceMatchingQueue.pop();
-      if (visitedFaces(currFaceMatching.first))
-        continue;
-      visitedFaces(currFaceMatching.first)=1;
-      
-      //combing field to start from the matching index
-      combedField.block(currFaceMatching.first, 0, 1, 3*(N-currFaceMatching.second))=rawField.block(currFaceMatching.first, 3*currFaceMatching.second, 1, 3*(N-currFaceMatching.second));
-      combedField.block(currFaceMatching.first, 3*(N-currFaceMatching.second), 1, 3*currFaceMatching.second)=rawField.block(currFaceMatching.first, 0, 1, 3*currFaceMatching.second);
-      
-      faceTurns(currFaceMatching.first)=currFaceMatching.second;
-      
-      for (int i=0;i<3;i++){
-        int nextMatching=(matching(FE(currFaceMatching.first,i)));
-        int nextFace=(EF(FE(currFaceMatching.first,i),0)==currFaceMatching.first ? EF(FE(currFaceMatching.first,i),1) : EF(FE(currFaceMatching.first,i),0));
-        nextMatching*=(EF(FE(currFaceMatching.first,i),0)==currFaceMatching.first ? 1.0 : -1.0);
-        nextMatching=(nextMatching+currFaceMatching.second+10*N)%N;  //killing negatives
-        if ((nextFace!=-1)&&(!visitedFaces(nextFace))&&(!faceIsCut(currFaceMatching.first,i)))
-          faceMatchingQueue.push(std::pair<int,int>(nextFace, nextMatching));
-        
-      }
-      
-    }while (!faceMatchingQueue.empty());
-    
-    //giving combed matching
-    for (int i=0;i<EF.rows();i++){
-      if ((EF(i,0)==-1)||(EF(i,1)==-1))
-        combedMatching(i)=-1;
-      else
-        combedMatching(i)=(faceTurns(EF(i,0))-faceTurns(EF(i,1))+matching(i)+1000000*N)%N;
-    }
+    Eigen::VectorXi faceTurns;
+    combing_face_turns(EF, FE, faceIsCut, matching, N, faceTurns);
+    combing_apply_turns(rawField, faceTurns, combedField);
+    combing_matching(EF, matching, faceTurns, N, combedMatching);
+  }
+  
+  //version with prescribed cuts from faces that does not copy the field: only the face turns and the combed matching are computed (see directional::CombedFieldView). faceIsCut can be empty for no cuts.
+  IGL_INLINE void combing(const Eigen::MatrixXi& EF,
+                          const Eigen::MatrixXi& FE,
+                          const Eigen::MatrixXi& faceIsCut,
+                          const Eigen::MatrixXd& rawField,
+                          const Eigen::VectorXi& matching,
+                          CombedFieldView& combedView)
+  {
+    int N=rawField.cols()/3;
+    combedView.rawField=&rawField;
+    combing_face_turns(EF, FE, faceIsCut, matching, N, combedView.faceTurns);
+    combing_matching(EF, matching, combedView.faceTurns, N, combedView.combedMatching);
+  }
+  
+  //version with a precomputed mesh topology (see directional::MeshTopology)
+  IGL_INLINE void combing(const MeshTopology& mesh,
+                          const Eigen::MatrixXd& rawField,
+                          const Eigen::VectorXi& matching,
+                          Eigen::MatrixXd& combedField)
+  {
+    Eigen::VectorXi faceTurns;
+    mesh.combing_tree().face_turns(matching, rawField.cols()/3, faceTurns);
+    combing_apply_turns(rawField, faceTurns, combedField);
+  }
+  
+  //version with prescribed cuts from faces and a precomputed mesh topology
+  IGL_INLINE void combing(const MeshTopology& mesh,
+                          const Eigen::MatrixXi& faceIsCut,
+                          const Eigen::MatrixXd& rawField,
+                          const Eigen::VectorXi& matching,
+                          Eigen::MatrixXd& combedField,
+                          Eigen::VectorXi& combedMatching)
+  {
+    int N=rawField.cols()/3;
+    Eigen::VectorXi faceTurns;
+    if (faceIsCut.size()==0)
+      mesh.combing_tree().face_turns(matching, N, faceTurns);
+    else
+      combing_face_turns(mesh.EF, mesh.FE, faceIsCut, matching, N, mesh.faceComponents, mesh.numComponents, faceTurns);
+    combing_apply_turns(rawField, faceTurns, combedField);
+    combing_matching(mesh.EF, matching, faceTurns, N, combedMatching);
+  }
+  
+  //version with a precomputed mesh topology that does not copy the field (see directional::CombedFieldView). faceIsCut can be empty for no cuts.
+  IGL_INLINE void combing(const MeshTopology& mesh,
+                          const Eigen::MatrixXi& faceIsCut,
+                          const Eigen::MatrixXd& rawField,
+                          const Eigen::VectorXi& matching,
+                          CombedFieldView& combedView)
+  {
+    int N=rawField.cols()/3;
+    combedView.rawField=&rawField;
+    if (faceIsCut.size()==0)
+      mesh.combing_tree().face_turns(matching, N, combedView.faceTurns);
+    else
+      combing_face_turns(mesh.EF, mesh.FE, faceIsCut, matching, N, mesh.faceComponents, mesh.numComponents, combedView.faceTurns);
+    combing_matching(mesh.EF, matching, combedView.faceTurns, N, combedView.combedMatching);
+  }
+  
+  //version with a precomputed combing tree (see directional::CombingTree), which is reused for all fields that are combed with the same cuts
+  IGL_INLINE void combing(const MeshTopology& mesh,
+                          const CombingTree& combingTree,
+                          const Eigen::MatrixXd& rawField,
+                          const Eigen::VectorXi& matching,
+                          Eigen::MatrixXd& combedField,
+                          Eigen::VectorXi& combedMatching)
+  {
+    int N=rawField.cols()/3;
+    Eigen::VectorXi faceTurns;
+    combingTree.face_turns(matching, N, faceTurns);
+    combing_apply_turns(rawField, faceTurns, combedField);
+    combing_matching(mesh.EF, matching, faceTurns, N, combedMatching);
+  }
+  
+  //version with a precomputed combing tree that does not copy the field (see directional::CombedFieldView)
+  IGL_INLINE void combing(const MeshTopology& mesh,
+                          const CombingTree& combingTree,
+                          const Eigen::MatrixXd& rawField,
+                          const Eigen::VectorXi& matching,
+                          CombedFieldView& combedView)
+  {
+    int N=rawField.cols()/3;
+    combedView.rawField=&rawField;
+    combingTree.face_turns(matching, N, combedView.faceTurns);
+    combing_matching(mesh.EF, matching, combedView.faceTurns, N, combedView.combedMatching);
+  }
+  
+  //version for a field in tangent form (see directional::TangentField) and a precomputed mesh topology
+  IGL_INLINE void combing(const MeshTopology& mesh,
+                          const TangentField& tangentField,
+                          const Eigen::VectorXi& matching,
+                          TangentField& combedField)
+  {
+    Eigen::VectorXi faceTurns;
+    mesh.combing_tree().face_turns(matching, tangentField.N(), faceTurns);
+    combing_apply_turns(tangentField, faceTurns, combedField);
+  }
+  
+  //version for a field in tangent form with prescribed cuts from faces and a precomputed mesh topology
+  IGL_INLINE void combing(const MeshTopology& mesh,
+                          const Eigen::MatrixXi& faceIsCut,
+                          const TangentField& tangentField,
+                          const Eigen::VectorXi& matching,
+                          TangentField& combedField,
+                          Eigen::VectorXi& combedMatching)
+  {
+    Eigen::VectorXi faceTurns;
+    combing_face_turns(mesh.EF, mesh.FE, faceIsCut, matching, tangentField.N(), mesh.faceComponents, mesh.numComponents, faceTurns);
+    combing_apply_turns(tangentField, faceTurns, combedField);
+    combing_matching(mesh.EF, matching, faceTurns, tangentField.N(), combedMatching);
   }
   
 }
@@ -9,6 +9,7 @@
 #include <directional/conjugate_frame_fields.h>
 #include <igl/speye.h>
 #include <igl/slice.h>
+#include <igl/parallel_for.h>
 #include <directional/polyroots.h>
 #include <directional/polyvector_to_raw.h>
 #include <directional/ccw_reorient_field.h>
@@ -45,17 +46,25 @@ namespace directional {
     int maxIter;
     bool doHardConstraints;
     
+    //global step: the quadratic forms only change with lambda, so their unknown-unknown blocks are factorized once per lambda value (see factorizeGlobalStep())
+    Eigen::VectorXi known, unknown;
+    Eigen::SparseMatrix<std::complex<double> > DDAuu, DDBuu, DDAuk, DDBuk, Wuu, Iuu;
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<std::complex<double> > > solverA, solverB;
+    double factorizedLambda;
+    bool isFactorized;
+    
     IGL_INLINE void localStep();
     IGL_INLINE void getPolyCoeffsForLocalSolve(const Eigen::Matrix<double, 4, 1> &s,
                                                const Eigen::Matrix<double, 4, 1> &z,
-                                               Eigen::Matrix<double, Eigen::Dynamic, 1> &polyCoeff);
+                                               Eigen::Matrix<double, 7, 1> &polyCoeff);
     
-    IGL_INLINE void globalStep(const Eigen::Matrix<int, Eigen::Dynamic, 1>  &isConstrained,
-                               const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1>  &Ak,
+    IGL_INLINE void precomputeGlobalStep(const Eigen::VectorXi &isConstrained);
+    IGL_INLINE bool factorizeGlobalStep();
+    IGL_INLINE void globalStep(const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1>  &Ak,
                                const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1>  &Bk);
-    IGL_INLINE void minQuadWithKnownMini(const Eigen::SparseMatrix<std::complex<double> > &Q,
-                                         const Eigen::SparseMatrix<std::complex<double> > &f,
-                                         const Eigen::VectorXi isConstrained,
+    IGL_INLINE void minQuadWithKnownMini(const Eigen::SimplicialLDLT<Eigen::SparseMatrix<std::complex<double> > > &solver,
+                                         const Eigen::SparseMatrix<std::complex<double> > &Quk,
+                                         const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> &f,
                                          const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> &xknown,
                                          Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> &x);
     IGL_INLINE void setFieldFromCoefficients();
@@ -77,7 +86,9 @@ lambdaOrtho(_lambdaOrtho),
 lambdaInit(_lambdaInit),
 maxIter(_maxIter),
 lambdaMultFactor(_lambdaMultFactor),
-doHardConstraints(_doHardConstraints)
+doHardConstraints(_doHardConstraints),
+factorizedLambda(0.),
+isFactorized(false)
 {
   Acoeff.resize(data.numF,1);
   Bcoeff.resize(data.numF,1);
@@ -90,7 +101,7 @@ doHardConstraints(_doHardConstraints)
 IGL_INLINE void directional::ConjugateFFSolver::
 getPolyCoeffsForLocalSolve(const Eigen::Matrix<double, 4, 1> &s,
                            const Eigen::Matrix<double, 4, 1> &z,
-                           Eigen::Matrix<double, Eigen::Dynamic, 1> &polyCoeff)
+                           Eigen::Matrix<double, 7, 1> &polyCoeff)
 {
   double s0 = s(0);
   double s1 = s(1);
@@ -101,7 +112,6 @@ getPolyCoeffsForLocalSolve(const Eigen::Matrix<double, 4, 1> &s,
   double z2 = z(2);
   double z3 = z(3);
   
-  polyCoeff.resize(7,1);
   polyCoeff(0) =  s0*s0* s1*s1* s2*s2* s3* z3*z3 +  s0*s0* s1*s1* s2* s3*s3* z2*z2 +  s0*s0* s1* s2*s2* s3*s3* z1*z1 +  s0* s1*s1* s2*s2* s3*s3* z0*z0 ;
   polyCoeff(1) = 2* s0*s0* s1*s1* s2* s3* z2*z2 + 2* s0*s0* s1*s1* s2* s3* z3*z3 + 2* s0*s0* s1* s2*s2* s3* z1*z1 + 2* s0*s0* s1* s2*s2* s3* z3*z3 + 2* s0*s0* s1* s2* s3*s3* z1*z1 + 2* s0*s0* s1* s2* s3*s3* z2*z2 + 2* s0* s1*s1* s2*s2* s3* z0*z0 + 2* s0* s1*s1* s2*s2* s3* z3*z3 + 2* s0* s1*s1* s2* s3*s3* z0*z0 + 2* s0* s1*s1* s2* s3*s3* z2*z2 + 2* s0* s1* s2*s2* s3*s3* z0*z0 + 2* s0* s1* s2*s2* s3*s3* z1*z1 ;
   polyCoeff(2) =  s0*s0* s1*s1* s2* z2*z2 +  s0*s0* s1*s1* s3* z3*z3 +  s0*s0* s1* s2*s2* z1*z1 + 4* s0*s0* s1* s2* s3* z1*z1 + 4* s0*s0* s1* s2* s3* z2*z2 + 4* s0*s0* s1* s2* s3* z3*z3 +  s0*s0* s1* s3*s3* z1*z1 +  s0*s0* s2*s2* s3* z3*z3 +  s0*s0* s2* s3*s3* z2*z2 +  s0* s1*s1* s2*s2* z0*z0 + 4* s0* s1*s1* s2* s3* z0*z0 + 4* s0* s1*s1* s2* s3* z2*z2 + 4* s0* s1*s1* s2* s3* z3*z3 +  s0* s1*s1* s3*s3* z0*z0 + 4* s0* s1* s2*s2* s3* z0*z0 + 4* s0* s1* s2*s2* s3* z1*z1 + 4* s0* s1* s2*s2* s3* z3*z3 + 4* s0* s1* s2* s3*s3* z0*z0 + 4* s0* s1* s2* s3*s3* z1*z1 + 4* s0* s1* s2* s3*s3* z2*z2 +  s0* s2*s2* s3*s3* z0*z0 +  s1*s1* s2*s2* s3* z3*z3 +  s1*s1* s2* s3*s3* z2*z2 +  s1* s2*s2* s3*s3* z1*z1;
@@ -115,19 +125,20 @@ getPolyCoeffsForLocalSolve(const Eigen::Matrix<double, 4, 1> &s,
 
 IGL_INLINE void directional::ConjugateFFSolver::localStep()
 {
-  for (int j =0; j<data.numF; ++j)
+  //the faces are independent, and every local solve only uses fixed-size types
+  igl::parallel_for(data.numF, [&](const int j)
   {
     Eigen::Matrix<double, 4, 1> xproj; xproj << pvU.row(j).transpose(),pvV.row(j).transpose();
     Eigen::Matrix<double, 4, 1> z = data.UH[j].transpose()*xproj;
     Eigen::Matrix<double, 4, 1> x;
     
-    Eigen::Matrix<double, Eigen::Dynamic, 1> polyCoeff;
+    Eigen::Matrix<double, 7, 1> polyCoeff;
     getPolyCoeffsForLocalSolve(data.s[j], z, polyCoeff);
-    Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> roots;
+    Eigen::Matrix<std::complex<double>, 6, 1> roots;
     
     //directional::polyvector_to_raw(data.B1(j),data.B2(j), polyCoeff,4,roots);
     
-    igl::polyRoots<double, double> (polyCoeff, roots);
+    igl::polyRoots<double, double, 7> (polyCoeff, roots);
     
     //  find closest real root to xproj
     double minDist = 1e10;
@@ -148,7 +159,7 @@ IGL_INLINE void directional::ConjugateFFSolver::localStep()
     
     pvU.row(j) << x(0),x(1);
     pvV.row(j) << x(2),x(3);
-  }
+  }, 1000);
 }
 
 
@@ -164,31 +175,72 @@ IGL_INLINE void directional::ConjugateFFSolver::setCoefficientsFromField()
 }
 
 
-IGL_INLINE void directional::ConjugateFFSolver::globalStep(const Eigen::Matrix<int, Eigen::Dynamic, 1>  &isConstrained,
-                                                           const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1>  &Ak,
+IGL_INLINE void directional::ConjugateFFSolver::precomputeGlobalStep(const Eigen::VectorXi &isConstrained)
+{
+  //without hard constraints, all coefficients are unknowns
+  int nc = (doHardConstraints ? isConstrained.sum() : 0);
+  known.setZero(nc,1);
+  unknown.setZero(data.numF-nc,1);
+  int indk = 0, indu = 0;
+  for (int i = 0; i<data.numF; ++i)
+    if (doHardConstraints && isConstrained[i])
+      known[indk++] = i;
+    else
+      unknown[indu++] = i;
+  
+  //the planarity weights and the identity are diagonal, so only the Laplacians couple unknowns to knowns
+  igl::slice(data.DDA, unknown, unknown, DDAuu);
+  igl::slice(data.DDB, unknown, unknown, DDBuu);
+  igl::slice(data.DDA, unknown, known, DDAuk);
+  igl::slice(data.DDB, unknown, known, DDBuk);
+  igl::slice(data.planarityWeight, unknown, unknown, Wuu);
+  igl::speye(unknown.rows(), unknown.rows(), Iuu);
+  
+  //the pattern does not depend on lambda
+  solverA.analyzePattern(DDAuu+Wuu+Iuu);
+  solverB.analyzePattern(DDBuu+Wuu);
+  isFactorized = false;
+}
+
+
+IGL_INLINE bool directional::ConjugateFFSolver::factorizeGlobalStep()
+{
+  //the quadratic forms are Hermitian, so a Hermitian LDLT replaces the general LU
+  solverA.factorize(DDAuu+lambda*Wuu+lambdaOrtho*Iuu);
+  solverB.factorize(DDBuu+lambda*Wuu);
+  factorizedLambda = lambda;
+  isFactorized = true;
+  if((solverA.info()!=Eigen::Success)||(solverB.info()!=Eigen::Success))
+  {
+    std::cerr<<"Decomposition failed!"<<std::endl;
+    return false;
+  }
+  return true;
+}
+
+
+IGL_INLINE void directional::ConjugateFFSolver::globalStep(const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1>  &Ak,
                                                            const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1>  &Bk)
 {
   setCoefficientsFromField();
   
-  Eigen::SparseMatrix<std::complex<double> > I;
-  igl::speye(data.numF, data.numF, I);
-  Eigen::SparseMatrix<std::complex<double> > QA = data.DDA+lambda*data.planarityWeight+lambdaOrtho*I;
-  Eigen::SparseMatrix<std::complex<double> > fA = (-2*lambda*data.planarityWeight*Acoeff).sparseView();
+  if ((!isFactorized)||(lambda!=factorizedLambda))
+    if (!factorizeGlobalStep())
+      return;
   
-  Eigen::SparseMatrix<std::complex<double> > QB = data.DDB+lambda*data.planarityWeight;
-  Eigen::SparseMatrix<std::complex<double> > fB = (-2*lambda*data.planarityWeight*Bcoeff).sparseView();
+  Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> fA = -2*lambda*(data.planarityWeight*Acoeff);
+  Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> fB = -2*lambda*(data.planarityWeight*Bcoeff);
   
   if(doHardConstraints)
   {
-    minQuadWithKnownMini(QA, fA, isConstrained, Ak, Acoeff);
-    minQuadWithKnownMini(QB, fB, isConstrained, Bk, Bcoeff);
+    minQuadWithKnownMini(solverA, DDAuk, fA, Ak, Acoeff);
+    minQuadWithKnownMini(solverB, DDBuk, fB, Bk, Bcoeff);
   }
   else
   {
-    Eigen::Matrix<int, Eigen::Dynamic, 1>isknown_; isknown_.setZero(data.numF,1);
     Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> xknown_; xknown_.setZero(0,1);
-    minQuadWithKnownMini(QA, fA, isknown_, xknown_, Acoeff);
-    minQuadWithKnownMini(QB, fB, isknown_, xknown_, Bcoeff);
+    minQuadWithKnownMini(solverA, DDAuk, fA, xknown_, Acoeff);
+    minQuadWithKnownMini(solverB, DDBuk, fB, xknown_, Bcoeff);
   }
   setFieldFromCoefficients();
   
@@ -197,15 +249,11 @@ IGL_INLINE void directional::ConjugateFFSolver::globalStep(const Eigen::Matrix<i
 
 IGL_INLINE void directional::ConjugateFFSolver::setFieldFromCoefficients()
 {
-  for (int i = 0; i <data.numF; ++i)
+  igl::parallel_for(data.numF, [&](const int i)
   {
     //    poly coefficients: 1, 0, -Acoeff, 0, Bcoeff
-    //    matlab code from roots (given there are no trailing zeros in the polynomial coefficients)
-    Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> polyCoeff(5,1);
-    polyCoeff<<1., 0., -Acoeff(i), 0., Bcoeff(i);
-    
-    Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> roots;
-    igl::polyRoots<std::complex<double> >(polyCoeff,roots);
+    Eigen::Matrix<std::complex<double>, 4, 1> roots;
+    igl::biquadraticRoots<double>(-Acoeff(i), Bcoeff(i), roots);
     
     std::complex<double> u = roots[0];
     int maxi = -1;
@@ -222,70 +270,40 @@ IGL_INLINE void directional::ConjugateFFSolver::setFieldFromCoefficients()
     std::complex<double> v = roots[maxi];
     pvU(i,0) = real(u); pvU(i,1) = imag(u);
     pvV(i,0) = real(v); pvV(i,1) = imag(v);
-  }
+  }, 1000);
   
 }
 
-IGL_INLINE void directional::ConjugateFFSolver::minQuadWithKnownMini(const Eigen::SparseMatrix<std::complex<double> > &Q,
-                                                                     const Eigen::SparseMatrix<std::complex<double> > &f,
-                                                                     const Eigen::VectorXi isConstrained,
+IGL_INLINE void directional::ConjugateFFSolver::minQuadWithKnownMini(const Eigen::SimplicialLDLT<Eigen::SparseMatrix<std::complex<double> > > &solver,
+                                                                     const Eigen::SparseMatrix<std::complex<double> > &Quk,
+                                                                     const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> &f,
                                                                      const Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> &xknown,
                                                                      Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> &x)
 {
-  int N = Q.rows();
+  int N = f.rows();
   
-  int nc = xknown.rows();
-  Eigen::VectorXi known; known.setZero(nc,1);
-  Eigen::VectorXi unknown; unknown.setZero(N-nc,1);
+  Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> fu(unknown.rows(),1);
+  for (int i = 0; i<unknown.rows(); ++i)
+    fu[i] = f[unknown[i]];
   
-  int indk = 0, indu = 0;
-  for (int i = 0; i<N; ++i)
-    if (isConstrained[i])
-    {
-      known[indk] = i;
-      indk++;
-    }
-    else
+  //the minimizer with x(known)=xknown solves -Quu*xu = Quk*xknown+.5*fu
+  Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> rhs = Quk*xknown+.5*fu;
+  Eigen::Matrix<std::complex<double>, Eigen::Dynamic, 1> b;
+  if (unknown.rows()>0)
+  {
+    b = -solver.solve(rhs);
+    if(solver.info()!=Eigen::Success)
     {
-      unknown[indu] = i;
-      indu++;
+      std::cerr<<"Solving failed!"<<std::endl;
+      return;
     }
-  
-  Eigen::SparseMatrix<std::complex<double>> Quu, Quk;
-  
-  igl::slice(Q,unknown, unknown, Quu);
-  igl::slice(Q,unknown, known, Quk);
-  
-  
-  std::vector<typename Eigen::Triplet<std::complex<double> > > tripletList;
-  
-  Eigen::SparseMatrix<std::complex<double> > fu(N-nc,1);
-  
-  igl::slice(f,unknown, Eigen::VectorXi::Zero(1,1), fu);
-  
-  Eigen::SparseMatrix<std::complex<double> > rhs = (Quk*xknown).sparseView()+.5*fu;
-  
-  Eigen::SparseLU< Eigen::SparseMatrix<std::complex<double>>> solver;
-  solver.compute(-Quu);
-  if(solver.info()!=Eigen::Success)
-  {
-    std::cerr<<"Decomposition failed!"<<std::endl;
-    return;
-  }
-  Eigen::SparseMatrix<std::complex<double>>  b  = solver.solve(rhs);
-  if(solver.info()!=Eigen::Success)
-  {
-    std::cerr<<"Solving failed!"<<std::endl;
-    return;
   }
   
-  indk = 0, indu = 0;
   x.setZero(N,1);
-  for (int i = 0; i<N; ++i)
-    if (isConstrained[i])
-      x[i] = xknown[indk++];
-    else
-      x[i] = b.coeff(indu++,0);
+  for (int i = 0; i<known.rows(); ++i)
+    x[known[i]] = xknown[i];
+  for (int i = 0; i<unknown.rows(); ++i)
+    x[unknown[i]] = b[i];
   
 }
 
@@ -339,6 +357,7 @@ IGL_INLINE double directional::ConjugateFFSolver::solve(const Eigen::VectorXi &i
   printf("\n\nInitial smoothness: %.5g\n",smoothnessValue);
   
   lambda = lambdaInit;
+  precomputeGlobalStep(isConstrained);
   
   bool doit = false;
   for (int iter = 0; iter<maxIter; ++iter)
@@ -348,7 +367,7 @@ IGL_INLINE double directional::ConjugateFFSolver::solve(const Eigen::VectorXi &i
     double oldMeanConj = meanConj;
     
     localStep();
-    globalStep(isConstrained, Ak, Bk);
+    globalStep(Ak, Bk);
     
     
     smoothnessValue = (Acoeff.adjoint()*data.DDA*Acoeff + Bcoeff.adjoint()*data.DDB*Bcoeff).real()[0];
@@ -0,0 +1,47 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2021 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef DIRECTIONAL_CONVERT_RAW_FIELD_H
+#define DIRECTIONAL_CONVERT_RAW_FIELD_H
+
+#include <Eigen/Core>
+#include <string>
+#include <igl/igl_inline.h>
+#include <directional/read_raw_field.h>
+#include <directional/write_raw_field.h>
+#include <directional/write_raw_field_binary.h>
+
+namespace directional
+{
+
+  // Converts a raw field file between the ASCII and the binary formats (see directional::read_raw_field and directional::write_raw_field_binary).
+  // The format of the input file is detected from its header.
+  // Inputs:
+  //   inFileName:      The file to convert.
+  //   outFileName:     The converted file.
+  //   binaryOutput:    Whether to write the binary format (column-major) or the ASCII format (in full precision).
+  //   singlePrecision: Whether the binary output is stored in float (ignored for ASCII output).
+  // Returns:
+  //   Whether or not the conversion was successful
+  bool IGL_INLINE convert_raw_field(const std::string& inFileName,
+                                    const std::string& outFileName,
+                                    const bool binaryOutput,
+                                    const bool singlePrecision=false)
+  {
+    int N;
+    Eigen::MatrixXd rawField;
+    if (!read_raw_field(inFileName, N, rawField))
+      return false;
+    
+    if (!binaryOutput)
+      return write_raw_field(outFileName, rawField, true);
+    if (singlePrecision)
+      return write_raw_field_binary(outFileName, Eigen::MatrixXf(rawField.cast<float>()));
+    return write_raw_field_binary(outFileName, rawField);
+  }
+}
+
+#endif
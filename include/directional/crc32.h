@@ -0,0 +1,48 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2021 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef DIRECTIONAL_CRC32_H
+#define DIRECTIONAL_CRC32_H
+
+#include <cstddef>
+#include <cstdint>
+#include <igl/igl_inline.h>
+
+namespace directional
+{
+  // The standard CRC-32 (IEEE 802.3, as in zlib) of a byte buffer, used to checksum binary files.
+  // Inputs:
+  //  data:   the buffer
+  //  size:   its size in bytes
+  //  crc:    the CRC of the preceding data, to checksum a buffer in several parts (0 to start)
+  // Returns:
+  //  the updated CRC
+  IGL_INLINE std::uint32_t crc32(const void* data,
+                                 const std::size_t size,
+                                 std::uint32_t crc=0)
+  {
+    static std::uint32_t table[256];
+    static bool tableBuilt = [](){
+      for (std::uint32_t i=0;i<256;i++){
+        std::uint32_t c=i;
+        for (int k=0;k<8;k++)
+          c = (c & 1 ? 0xEDB88320u^(c>>1) : c>>1);
+        table[i]=c;
+      }
+      return true;
+    }();
+    (void)tableBuilt;
+    
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    for (std::size_t i=0;i<size;i++)
+      crc = table[(crc^bytes[i]) & 0xFF]^(crc>>8);
+    return ~crc;
+  }
+}
+
+#endif
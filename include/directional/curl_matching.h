@@ -18,73 +18,55 @@
 #include <igl/edge_topology.h>
 #include <directional/representative_to_raw.h>
 #include <directional/effort_to_indices.h>
+#include <directional/MeshTopology.h>
+#include <directional/edge_transport.h>
+#include <igl/parallel_for.h>
 
 namespace directional
   {
-  // Takes a field in raw form and computes both the curl-matching effort and the consequent curl matching on every edge.
-  // Important: if the Raw field in not CCW ordered, the result is meaningless.
+  // Takes a field in raw form and computes both the curl-matching effort and the consequent curl matching on every edge, given precomputed edge vectors and transport (see directional::edge_transport).
+  // The edges are processed in parallel, each writing only its own entries, so the result does not depend on the number of threads.
   // Input:
-  //  V:      #V x 3 vertex coordinates
-  //  F:      #F x 3 face vertex indices
-  //  EV:     #E x 2 edges to vertices indices
-  //  EF:     #E x 2 edges to faces indices
-  //  raw:    The directional field, assumed to be ordered CCW, and in xyzxyzxyz...xyz (3*N cols) form. The degree is inferred by the size.
+  //  EF:             #E x 2 edges to faces indices
+  //  B1, B2:         #F x 3 matrices representing the local base of each face.
+  //  edgeVectors:    #E x 3 normalized edge vectors
+  //  edgeTransport:  #E transport from EF(i,0) to EF(i,1)
+  //  raw:            The directional field, assumed to be ordered CCW, and in xyzxyzxyz...xyz (3*N cols) form. The degree is inferred by the size.
   // Output:
-  // matching: #E matching function, where vector k in EF(i,0) matches to vector (k+matching(k))%N in EF(i,1). In case of boundary, there is a -1.
-  //  effort: #E principal matching efforts.
-  // curlNorm: the L2-norm of the curl vector
-  //  singVertices: indices (into V) of which vertices are singular; including boundary vertices which carry the singularity of their loop
-  //  singIndices: the index of the singular vertices (corresponding with singIndices), relative to N (the true index is then i/N).
-  IGL_INLINE void curl_matching(const Eigen::MatrixXd& V,
-                                const Eigen::MatrixXi& F,
-                                const Eigen::MatrixXi& EV,
-                                const Eigen::MatrixXi& EF,
-                                const Eigen::MatrixXi& FE,
+  //  as below.
+  IGL_INLINE void curl_matching(const Eigen::MatrixXi& EF,
+                                const Eigen::MatrixXd& B1,
+                                const Eigen::MatrixXd& B2,
+                                const Eigen::MatrixXd& edgeVectors,
+                                const Eigen::VectorXcd& edgeTransport,
                                 const Eigen::MatrixXd& rawField,
                                 Eigen::VectorXi& matching,
                                 Eigen::VectorXd& effort,
-                                Eigen::VectorXd& curlNorm,
-                                Eigen::VectorXi& singVertices,
-                                Eigen::VectorXi& singIndices)
+                                Eigen::VectorXd& curlNorm)
   {
     
     typedef std::complex<double> Complex;
     using namespace Eigen;
     using namespace std;
     
-    MatrixXd B1, B2, B3;
-    igl::local_basis(V, F, B1, B2, B3);
-    
     int N = rawField.cols() / 3;
     
     matching.conservativeResize(EF.rows());
     matching.setConstant(-1);
-    curlNorm.conservativeResize(EF.rows());
-    
-    VectorXcd edgeTransport(EF.rows());  //the difference in the angle representation of edge i from EF(i,0) to EF(i,1)
-    MatrixXd edgeVectors(EF.rows(), 3);
-    for (int i = 0; i < EF.rows(); i++) {
-      if (EF(i, 0) == -1 || EF(i, 1) == -1)
-        continue;
-      edgeVectors.row(i) = (V.row(EV(i, 1)) - V.row(EV(i, 0))).normalized();
-      Complex ef(edgeVectors.row(i).dot(B1.row(EF(i, 0))), edgeVectors.row(i).dot(B2.row(EF(i, 0))));
-      Complex eg(edgeVectors.row(i).dot(B1.row(EF(i, 1))), edgeVectors.row(i).dot(B2.row(EF(i, 1))));
-      edgeTransport(i) = eg / ef;
-    }
+    curlNorm = VectorXd::Zero(EF.rows());
     
     effort = VectorXd::Zero(EF.rows());
-    for (int i = 0; i < EF.rows(); i++) {
+    igl::parallel_for(EF.rows(), [&](const int i){
       if (EF(i, 0) == -1 || EF(i, 1) == -1)
-        continue;
+        return;
       //computing free coefficient effort (a.k.a. [Diamanti et al. 2014])
-      //Complex freeCoeffEffort(1.0, 0.0);
       int indexMinFromZero=0;
       //finding where the 0 vector in EF(i,0) goes to with smallest rotation angle in EF(i,1), computing the effort, and then adjusting the matching to have principal effort.
       double minCurl = 32767000.0;
       for (int j = 0; j < N; j++) {
         double currCurl = 0;
         for (int k=0;k<N;k++){
-          RowVector3d vecDiff =rawField.block(EF(i, 1), 3 * ((j+k)%N), 1, 3)-rawField.block(EF(i, 0), 3*k, 1, 3);
+          RowVector3d vecDiff =rawField.block<1,3>(EF(i, 1), 3 * ((j+k)%N))-rawField.block<1,3>(EF(i, 0), 3*k);
           currCurl +=pow(edgeVectors.row(i).dot(vecDiff),2.0);
         }
         
@@ -100,22 +82,91 @@ namespace directional
       //computing the full effort for 0->indexMinFromZero, and readjusting the matching to fit principal effort
       double currEffort=0;
       for (int j = 0; j < N; j++) {
-        RowVector3d vecjf = rawField.block(EF(i, 0), 3*j, 1, 3);
+        RowVector3d vecjf = rawField.block<1,3>(EF(i, 0), 3*j);
         Complex vecjfc = Complex(vecjf.dot(B1.row(EF(i, 0))), vecjf.dot(B2.row(EF(i, 0))));
-        RowVector3d vecjg = rawField.block(EF(i, 1), 3 * ((matching(i)+j+N)%N), 1, 3);
+        RowVector3d vecjg = rawField.block<1,3>(EF(i, 1), 3 * ((matching(i)+j+N)%N));
         Complex vecjgc = Complex(vecjg.dot(B1.row(EF(i, 1))), vecjg.dot(B2.row(EF(i, 1))));
         Complex transvecjfc = vecjfc*edgeTransport(i);
-        //cout<<"transvecjfc, vecjgc: "<<transvecjfc<<","<<vecjgc<<endl;
         currEffort+= arg(vecjgc / transvecjfc);
-        //cout<<"arg(vecjgc / transvecjfc): "<<arg(vecjgc / transvecjfc)<<endl;
       }
       
       effort(i) = currEffort;
-      
-    }
+    }, 1000);
+  }
+  
+  // Takes a field in raw form and computes both the curl-matching effort and the consequent curl matching on every edge, given a precomputed local basis.
+  // Important: if the Raw field in not CCW ordered, the result is meaningless.
+  // Input:
+  //  V:      #V x 3 vertex coordinates
+  //  EV:     #E x 2 edges to vertices indices
+  //  EF:     #E x 2 edges to faces indices
+  //  B1, B2: #F x 3 matrices representing the local base of each face.
+  //  raw:    The directional field, assumed to be ordered CCW, and in xyzxyzxyz...xyz (3*N cols) form. The degree is inferred by the size.
+  // Output:
+  // matching: #E matching function, where vector k in EF(i,0) matches to vector (k+matching(k))%N in EF(i,1). In case of boundary, there is a -1.
+  //  effort: #E principal matching efforts.
+  // curlNorm: the L2-norm of the curl vector
+  IGL_INLINE void curl_matching(const Eigen::MatrixXd& V,
+                                const Eigen::MatrixXi& EV,
+                                const Eigen::MatrixXi& EF,
+                                const Eigen::MatrixXd& B1,
+                                const Eigen::MatrixXd& B2,
+                                const Eigen::MatrixXd& rawField,
+                                Eigen::VectorXi& matching,
+                                Eigen::VectorXd& effort,
+                                Eigen::VectorXd& curlNorm)
+  {
+    Eigen::MatrixXd edgeVectors;
+    Eigen::VectorXcd edgeTransport;
+    edge_transport(V, EV, EF, B1, B2, edgeVectors, edgeTransport);
+    curl_matching(EF, B1, B2, edgeVectors, edgeTransport, rawField, matching, effort, curlNorm);
+  }
+  
+  // Takes a field in raw form and computes both the curl-matching effort and the consequent curl matching on every edge.
+  // Important: if the Raw field in not CCW ordered, the result is meaningless.
+  // Input:
+  //  V:      #V x 3 vertex coordinates
+  //  F:      #F x 3 face vertex indices
+  //  EV:     #E x 2 edges to vertices indices
+  //  EF:     #E x 2 edges to faces indices
+  //  raw:    The directional field, assumed to be ordered CCW, and in xyzxyzxyz...xyz (3*N cols) form. The degree is inferred by the size.
+  // Output:
+  // matching: #E matching function, where vector k in EF(i,0) matches to vector (k+matching(k))%N in EF(i,1). In case of boundary, there is a -1.
+  //  effort: #E principal matching efforts.
+  // curlNorm: the L2-norm of the curl vector
+  //  singVertices: indices (into V) of which vertices are singular; including boundary vertices which carry the singularity of their loop
+  //  singIndices: the index of the singular vertices (corresponding with singIndices), relative to N (the true index is then i/N).
+  IGL_INLINE void curl_matching(const Eigen::MatrixXd& V,
+                                const Eigen::MatrixXi& F,
+                                const Eigen::MatrixXi& EV,
+                                const Eigen::MatrixXi& EF,
+                                const Eigen::MatrixXi& FE,
+                                const Eigen::MatrixXd& rawField,
+                                Eigen::VectorXi& matching,
+                                Eigen::VectorXd& effort,
+                                Eigen::VectorXd& curlNorm,
+                                Eigen::VectorXi& singVertices,
+                                Eigen::VectorXi& singIndices)
+  {
+    Eigen::MatrixXd B1, B2, B3;
+    igl::local_basis(V, F, B1, B2, B3);
+    curl_matching(V, EV, EF, B1, B2, rawField, matching, effort, curlNorm);
     
     //Getting final singularities and their indices
-    effort_to_indices(V,F,EV, EF, effort,matching,N,singVertices,singIndices);
+    effort_to_indices(V,F,EV, EF, effort,matching,rawField.cols()/3,singVertices,singIndices);
+  }
+  
+  //version with a precomputed mesh topology (see directional::MeshTopology)
+  IGL_INLINE void curl_matching(const MeshTopology& mesh,
+                                const Eigen::MatrixXd& rawField,
+                                Eigen::VectorXi& matching,
+                                Eigen::VectorXd& effort,
+                                Eigen::VectorXd& curlNorm,
+                                Eigen::VectorXi& singVertices,
+                                Eigen::VectorXi& singIndices)
+  {
+    curl_matching(mesh.EF, mesh.B1, mesh.B2, mesh.edgeVectors, mesh.edgeTransport, rawField, matching, effort, curlNorm);
+    effort_to_indices(mesh, effort, matching, rawField.cols()/3, singVertices, singIndices);
   }
   
   //version with representative vector (for N-RoSy) as input.
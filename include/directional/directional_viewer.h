@@ -20,6 +20,8 @@
 #include <directional/halfedge_highlights.h>
 #include <directional/vertex_highlights.h>
 #include <directional/streamlines.h>
+#include <directional/combing.h>
+#include <directional/evenly_spaced_streamlines.h>
 #include <igl/edge_topology.h>
 
 
@@ -226,6 +228,22 @@ namespace directional
       data_list[NUMBER_OF_SUBMESHES*meshNum+FIELD_MESH].show_lines=false;
     }
     
+    //Shows a combed field given as a view (see directional::CombedFieldView): the original field is shown, and per-vector colors C by combed index (e.g., from indexed_glyph_colors()) are moved to the original vectors
+    void IGL_INLINE set_combed_field(const directional::CombedFieldView& combedView,
+                                     const Eigen::MatrixXd& C=Eigen::MatrixXd(),
+                                     const int meshNum=0,
+                                     const double sizeRatio = 0.9,
+                                     const int sparsity=0,
+                                     const double offsetRatio = 0.2)
+    {
+      Eigen::MatrixXd originalColors=C;
+      if ((C.rows()==combedView.num_faces())&&(C.cols()==3*combedView.N()))
+        for (int i=0;i<C.rows();i++)
+          for (int j=0;j<combedView.N();j++)
+            originalColors.block<1,3>(i,3*combedView.original_index(i,j))=C.block<1,3>(i,3*j);
+      set_field(*combedView.rawField, originalColors, meshNum, sizeRatio, sparsity, offsetRatio);
+    }
+    
     void IGL_INLINE set_field_colors(const Eigen::MatrixXd& C=Eigen::MatrixXd(),
                                      const int meshNum=0,
                                      const double sizeRatio = 0.9,
@@ -350,9 +368,9 @@ namespace directional
       double width = widthRatio*igl::avg_edge_length(VList[meshNum], FList[meshNum]);
       
       //generating colors according to original elements and their time signature
-      Eigen::MatrixXd slColors(slState[meshNum].P1.rows(),3);
+      Eigen::MatrixXd slColors(slState[meshNum].numSegments,3);
       
-      for (int i=0;i<slState[meshNum].origFace.size();i++){
+      for (int i=0;i<slState[meshNum].numSegments;i++){
         if (fieldColors[meshNum].rows()==1)
           slColors.row(i)=fieldColors[meshNum];
         else{
@@ -376,6 +394,30 @@ namespace directional
       
     }
     
+    //Shows evenly-spaced streamlines of the field (see directional::evenly_spaced_streamlines()) in place of the advancing ones, separationRatio average edge lengths apart
+    void IGL_INLINE set_evenly_spaced_streamlines(const int meshNum=0,
+                                                  const double separationRatio=3.0,
+                                                  const double widthRatio=0.05){
+      
+      double l = igl::avg_edge_length(VList[meshNum], FList[meshNum]);
+      directional::MeshTopology mesh(VList[meshNum], FList[meshNum]);
+      Eigen::MatrixXd P1, P2;
+      Eigen::VectorXi lineIndices;
+      directional::evenly_spaced_streamlines(mesh, rawField[meshNum], separationRatio*l, P1, P2, lineIndices);
+      
+      Eigen::RowVector3d lineColor = default_glyph_color();
+      if (fieldColors[meshNum].rows()==1)
+        lineColor=fieldColors[meshNum].leftCols(3);
+      Eigen::MatrixXd slColors = lineColor.replicate(P1.rows(),1);
+      Eigen::MatrixXd VStream, CStream;
+      Eigen::MatrixXi FStream;
+      directional::line_cylinders(P1, P2, widthRatio*l, slColors, 4, VStream, FStream, CStream);
+      data_list[NUMBER_OF_SUBMESHES*meshNum+STREAMLINE_MESH].clear();
+      data_list[NUMBER_OF_SUBMESHES*meshNum+STREAMLINE_MESH].set_mesh(VStream, FStream);
+      data_list[NUMBER_OF_SUBMESHES*meshNum+STREAMLINE_MESH].set_colors(CStream);
+      data_list[NUMBER_OF_SUBMESHES*meshNum+STREAMLINE_MESH].show_lines = false;
+    }
+    
     void IGL_INLINE set_isolines(const Eigen::MatrixXd& cutV,
                                  const Eigen::MatrixXi& cutF,
                                  const Eigen::MatrixXd& vertexFunction,
@@ -19,6 +19,7 @@
 #include <set>
 #include <unordered_map>
 #include "tree.h"
+#include "face_components.h"
 
 
 namespace directional
@@ -55,7 +56,9 @@ namespace directional
     
     igl::boundary_loop(F, boundaryLoops);
     int numBoundaries=boundaryLoops.size();
-    int numGenerators=2-numBoundaries-eulerChar;
+    VectorXi faceComponents;
+    int numComponents=face_components(EF, F.rows(), faceComponents);
+    int numGenerators=2*numComponents-numBoundaries-eulerChar;  //the Euler characteristic is the sum over the components
     
     vector<Triplet<double> > basisCycleTriplets(EV.rows() * 2);
     
@@ -124,8 +124,10 @@ namespace directional
 			else {
 				n_data.sl_state.start_point.row(i) = n_data.sl_state0.start_point.row(i);
 				n_data.sl_state.end_point.row(i) = n_data.sl_state0.end_point.row(i);
+				n_data.sl_state.end_bary.row(i) = n_data.sl_state0.end_bary.row(i);
 				n_data.sl_state.current_direction(i) = n_data.sl_state0.current_direction(i);
 				n_data.sl_state.current_face(i) = n_data.sl_state0.current_face(i);
+				n_data.sl_state.current_entry(i) = n_data.sl_state0.current_entry(i);
 				n_data.currentLifespan(i) = 0;
 			}
 		}
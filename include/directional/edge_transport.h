@@ -0,0 +1,52 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2018 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef DIRECTIONAL_EDGE_TRANSPORT_H
+#define DIRECTIONAL_EDGE_TRANSPORT_H
+
+#include <complex>
+#include <Eigen/Core>
+#include <igl/igl_inline.h>
+#include <igl/parallel_for.h>
+
+namespace directional
+{
+  // Computes the discrete (Levi-Civita) transport across every inner edge: the ratio between the complex representations of the edge vector in the local bases of its two adjacent faces.
+  // A vector with complex coordinates z in EF(i,0) is transported to z*edgeTransport(i) in EF(i,1).
+  // Input:
+  //  V:      #V x 3 vertex coordinates
+  //  EV:     #E x 2 edges to vertices indices
+  //  EF:     #E x 2 edges to faces indices
+  //  B1, B2: #F x 3 matrices representing the local base of each face.
+  // Output:
+  //  edgeVectors:    #E x 3 normalized edge vectors (from EV(i,0) to EV(i,1)), undefined on boundary edges.
+  //  edgeTransport:  #E the transport from EF(i,0) to EF(i,1), undefined on boundary edges.
+  IGL_INLINE void edge_transport(const Eigen::MatrixXd& V,
+                                 const Eigen::MatrixXi& EV,
+                                 const Eigen::MatrixXi& EF,
+                                 const Eigen::MatrixXd& B1,
+                                 const Eigen::MatrixXd& B2,
+                                 Eigen::MatrixXd& edgeVectors,
+                                 Eigen::VectorXcd& edgeTransport)
+  {
+    typedef std::complex<double> Complex;
+    using namespace Eigen;
+
+    edgeVectors.resize(EF.rows(), 3);
+    edgeTransport.resize(EF.rows());
+    igl::parallel_for(EF.rows(), [&](const int i){
+      if (EF(i, 0) == -1 || EF(i, 1) == -1)
+        return;
+      edgeVectors.row(i) = (V.row(EV(i, 1)) - V.row(EV(i, 0))).normalized();
+      Complex ef(edgeVectors.row(i).dot(B1.row(EF(i, 0))), edgeVectors.row(i).dot(B2.row(EF(i, 0))));
+      Complex eg(edgeVectors.row(i).dot(B1.row(EF(i, 1))), edgeVectors.row(i).dot(B2.row(EF(i, 1))));
+      edgeTransport(i) = eg / ef;
+    }, 1000);
+  }
+}
+
+#endif
@@ -18,6 +18,8 @@
 //#include <igl/parallel_transport_angles.h>
 #include <igl/boundary_loop.h>
 #include <directional/dual_cycles.h>
+#include <directional/SingularityDetector.h>
+#include <directional/MeshTopology.h>
 
 
 namespace directional
@@ -48,6 +50,71 @@ namespace directional
   }
   
   
+  // Version with a precomputed singularity detector (see directional::SingularityDetector), returning only inner-vertex singularities.
+  // This costs a single sparse product and a rounding per call, and should be used when the singularities of many fields on the same mesh are needed.
+  // Input:
+  //  sd:     the singularity detector of the mesh
+  //  effort: #E the effort on all edges (boundary edges are ignored)
+  //  N:      The degree of the field
+  // Output:
+  //  singVertices: indices (into V) of singular inner vertices
+  //  singIndices:  the index of the singular vertices relative to N (the true index is then i/N)
+  IGL_INLINE void effort_to_indices(const SingularityDetector& sd,
+                                    const Eigen::VectorXd& effort,
+                                    const Eigen::VectorXi& matching,
+                                    const int N,
+                                    Eigen::VectorXi& singVertices,
+                                    Eigen::VectorXi& singIndices)
+  {
+    Eigen::VectorXi fullIndices;
+    directional::effort_to_indices(sd.basisCycles, effort, matching, sd.cycleCurvature, N, fullIndices);
+    
+    std::vector<int> singVerticesList;
+    std::vector<int> singIndicesList;
+    for (int i=0;i<sd.vertex2cycle.size();i++){
+      if (sd.isBoundaryVertex(i))  //removing boundary indices
+        continue;
+      int index=fullIndices(sd.vertex2cycle(i));
+      if (index!=0){
+        singVerticesList.push_back(i);
+        singIndicesList.push_back(index);
+      }
+    }
+    
+    singVertices.resize(singVerticesList.size());
+    singIndices.resize(singIndicesList.size());
+    for (int i=0;i<singVerticesList.size();i++){
+      singVertices(i)=singVerticesList[i];
+      singIndices(i)=singIndicesList[i];
+    }
+  }
+  
+  // Version with precomputed dual cycles, returning only inner-vertex singularities
+  // Input:
+  //  basisCycles, cycleCurvature, vertex2cycle, innerEdges: as given by directional::dual_cycles
+  //  isBoundaryVertex: #V 1 for vertices on the boundary, 0 otherwise
+  //  effort:           #E the effort on all edges (boundary edges are ignored)
+  //  N:                The degree of the field
+  // Output:
+  //  singVertices: indices (into V) of singular inner vertices
+  //  singIndices:  the index of the singular vertices relative to N (the true index is then i/N)
+  IGL_INLINE void effort_to_indices(const Eigen::SparseMatrix<double>& basisCycles,
+                                    const Eigen::VectorXd& cycleCurvature,
+                                    const Eigen::VectorXi& vertex2cycle,
+                                    const Eigen::VectorXi& innerEdges,
+                                    const Eigen::VectorXi& isBoundaryVertex,
+                                    const Eigen::VectorXd& effort,
+                                    const Eigen::VectorXi& matching,
+                                    const int N,
+                                    Eigen::VectorXi& singVertices,
+                                    Eigen::VectorXi& singIndices)
+  {
+    SingularityDetector sd;
+    sd.set_cycles(effort.size(), basisCycles, cycleCurvature, vertex2cycle, innerEdges, isBoundaryVertex);
+    directional::effort_to_indices(sd, effort, matching, N, singVertices, singIndices);
+  }
+  
+  
   // minimal version without precomputed cycles or inner edges, returning only inner-vertex singularities
   IGL_INLINE void effort_to_indices(const Eigen::MatrixXd& V,
                                     const Eigen::MatrixXi& F,
@@ -64,37 +131,26 @@ namespace directional
     Eigen::VectorXi vertex2cycle;
     Eigen::VectorXi innerEdges;
     directional::dual_cycles(V, F,EV, EF, basisCycles, cycleCurvature, vertex2cycle, innerEdges);
-    Eigen::VectorXd effortInner(innerEdges.size());
-    for (int i=0;i<innerEdges.size();i++)
-      effortInner(i)=effort(innerEdges(i));
-    Eigen::VectorXi fullIndices;
-    directional::effort_to_indices(basisCycles, effortInner, matching, cycleCurvature, N, fullIndices);
-   
-    Eigen::VectorXi indices(V.rows());
-    for (int i=0;i<V.rows();i++)
-      indices(i)=fullIndices(vertex2cycle(i));
     
-    //removing boundary indices
-   std::vector<std::vector<int> > L;
+    std::vector<std::vector<int> > L;
     igl::boundary_loop(F, L);
+    Eigen::VectorXi isBoundaryVertex=Eigen::VectorXi::Zero(V.rows());
     for (int j=0;j<L.size();j++)
       for (int k=0;k<L[j].size();k++)
-        indices(L[j][k])=0;
-                    
-    std::vector<int> singVerticesList;
-    std::vector<int> singIndicesList;
-    for (int i=0;i<V.rows();i++)
-      if (indices(i)!=0){
-        singVerticesList.push_back(i);
-        singIndicesList.push_back(indices(i));
-      }
+        isBoundaryVertex(L[j][k])=1;
     
-    singVertices.resize(singVerticesList.size());
-    singIndices.resize(singIndicesList.size());
-    for (int i=0;i<singVerticesList.size();i++){
-      singVertices(i)=singVerticesList[i];
-      singIndices(i)=singIndicesList[i];
-    }
+    directional::effort_to_indices(basisCycles, cycleCurvature, vertex2cycle, innerEdges, isBoundaryVertex, effort, matching, N, singVertices, singIndices);
+  }
+  
+  // Version with a precomputed mesh topology (see directional::MeshTopology)
+  IGL_INLINE void effort_to_indices(const MeshTopology& mesh,
+                                    const Eigen::VectorXd& effort,
+                                    const Eigen::VectorXi& matching,
+                                    const int N,
+                                    Eigen::VectorXi& singVertices,
+                                    Eigen::VectorXi& singIndices)
+  {
+    directional::effort_to_indices(mesh.singularityDetector, effort, matching, N, singVertices, singIndices);
   }
 }
 
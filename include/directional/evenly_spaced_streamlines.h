@@ -0,0 +1,324 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2021 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef DIRECTIONAL_EVENLY_SPACED_STREAMLINES_H
+#define DIRECTIONAL_EVENLY_SPACED_STREAMLINES_H
+
+#include <cmath>
+#include <cassert>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <Eigen/Core>
+#include <igl/igl_inline.h>
+#include <igl/PI.h>
+#include <directional/MeshTopology.h>
+#include <directional/streamlines.h>
+
+namespace directional
+{
+  // An occupancy index of points sampled along streamlines: a uniform grid whose cells are as large as the largest query radius, so that a query only visits the 27 cells around it.
+  // Only the occupied cells are stored (hashed), so the memory is proportional to the number of samples and not to the volume of the bounding box.
+  struct StreamlineOccupancyGrid{
+  public:
+
+    double cellSize;
+    std::unordered_map<long long, std::vector<int> > cells;   //sample indices by cell
+
+    std::vector<Eigen::RowVector3d> points;     //sample points
+    std::vector<Eigen::RowVector3d> tangents;   //unit tangents of the streamlines at the samples
+    std::vector<int> lines;                     //streamline of each sample
+    std::vector<double> arcs;                   //signed arc length of each sample from the seed of its streamline
+    std::vector<int> faces;                     //face of each sample
+    std::vector<Eigen::Vector3d> barys;         //barycentric coordinates of each sample in its face
+
+    StreamlineOccupancyGrid(const double _cellSize=1.0):cellSize(_cellSize){}
+    ~StreamlineOccupancyGrid(){}
+
+    int num_samples() const {return points.size();}
+
+    long long cell_key(const int x, const int y, const int z) const {return ((long long)(x & 0x1FFFFF)<<42) | ((long long)(y & 0x1FFFFF)<<21) | (long long)(z & 0x1FFFFF);}
+
+    IGL_INLINE void insert(const Eigen::RowVector3d& point,
+                           const Eigen::RowVector3d& tangent,
+                           const int line,
+                           const double arc,
+                           const int face,
+                           const Eigen::Vector3d& bary)
+    {
+      cells[cell_key((int)std::floor(point(0)/cellSize), (int)std::floor(point(1)/cellSize), (int)std::floor(point(2)/cellSize))].push_back(points.size());
+      points.push_back(point);
+      tangents.push_back(tangent);
+      lines.push_back(line);
+      arcs.push_back(arc);
+      faces.push_back(face);
+      barys.push_back(bary);
+    }
+
+    // Whether no sample is closer than radius (at most cellSize) to point, ignoring samples of other streamline families (|cos| of the angle between the tangents under cosThreshold)
+    // and samples of the same line that are less than selfArc away along it.
+    IGL_INLINE bool is_free(const Eigen::RowVector3d& point,
+                            const Eigen::RowVector3d& tangent,
+                            const double radius,
+                            const double cosThreshold,
+                            const int line,
+                            const double arc,
+                            const double selfArc) const
+    {
+      assert(radius<=cellSize && "StreamlineOccupancyGrid::is_free(): the radius is larger than the cells");
+      int x=(int)std::floor(point(0)/cellSize), y=(int)std::floor(point(1)/cellSize), z=(int)std::floor(point(2)/cellSize);
+      for (int dx=-1;dx<=1;dx++)
+        for (int dy=-1;dy<=1;dy++)
+          for (int dz=-1;dz<=1;dz++){
+            std::unordered_map<long long, std::vector<int> >::const_iterator ci=cells.find(cell_key(x+dx, y+dy, z+dz));
+            if (ci==cells.end())
+              continue;
+            for (size_t i=0;i<ci->second.size();i++){
+              int s=ci->second[i];
+              if ((points[s]-point).squaredNorm()>=radius*radius)
+                continue;
+              if (std::abs(tangents[s].dot(tangent))<cosThreshold)
+                continue;
+              if ((lines[s]==line)&&(std::abs(arcs[s]-arc)<selfArc))
+                continue;
+              return false;
+            }
+          }
+      return true;
+    }
+  };
+
+
+  // Traces evenly-spaced streamlines of a directional field, as in Jobard and Lefer, "Creating Evenly-Spaced Streamlines of Arbitrary Density", 1997.
+  // Each streamline is traced in both directions from its seed, and is terminated when it comes closer than testRatio*separation to another streamline of the same family, closes on itself, or reaches the boundary.
+  // The streamlines of an N-field (N>2) belong to N/2 (even N) or N (odd N) families, which cross each other freely.
+  // New seeds are placed at distance separation on both sides of each streamline (walking on the mesh), and the faces are scanned in order for seeds in the regions that are left empty.
+  // All proximity tests go through a StreamlineOccupancyGrid, so the running time is proportional to the total length of the streamlines.
+  // Input:
+  //   mesh          mesh topology
+  //   rawField      #F by 3N raw field
+  //   separation    distance between adjacent streamlines
+  //   testRatio     the fraction of separation under which a streamline is terminated, in (0,1] (larger values are clamped to 1; Jobard and Lefer use 0.5)
+  // Output:
+  //   P1, P2        #S by 3 start and end points of the streamline segments
+  //   lineIndices   #S the streamline of each segment
+  IGL_INLINE void evenly_spaced_streamlines(const MeshTopology& mesh,
+                                            const Eigen::MatrixXd& rawField,
+                                            const double separation,
+                                            const double testRatio,
+                                            Eigen::MatrixXd& P1,
+                                            Eigen::MatrixXd& P2,
+                                            Eigen::VectorXi& lineIndices)
+  {
+    using namespace Eigen;
+    using namespace std;
+
+    const MatrixXd& V=mesh.V;
+    const MatrixXi& F=mesh.F;
+
+    //the tracing data (sorted and normalized field, matching, barycentric directions)
+    StreamlineData data;
+    StreamlineState state;
+    streamlines_init(mesh, rawField, VectorXi::Zero(1), 0, data, state);
+
+    const int N=data.degree;
+    const int numFamilies=(N%2==0 ? N/2 : N);
+    const double cosThreshold=(N<=2 ? -1.0 : std::cos(N%2==0 ? igl::PI/(double)N : igl::PI/(2.0*N)));  //half the angle between families
+    assert(testRatio>0.0 && "evenly_spaced_streamlines(): testRatio must be positive");
+    const double testDistance=std::min(testRatio, 1.0)*separation;  //a seed is only as far as separation from its neighbors
+    const double sampleSpacing=testDistance/2.0;
+    const double selfArc=2.0*separation;     //a line only terminates itself when it loops back
+    const int maxCrossings=10*F.rows()+64;   //per half line, against spiraling into singularities
+    const int maxZeroCrossings=64;           //consecutive crossings without progress (around a vertex)
+
+    StreamlineOccupancyGrid grid(separation);   //testDistance<=separation, so the cells cover every query radius
+    vector<RowVector3d> P1List, P2List;
+    vector<int> lineList;
+    vector<int> lineFirstSample;
+
+    auto point_at=[&](const int f, const Vector3d& b)->RowVector3d{
+      return b(0)*V.row(F(f,0))+b(1)*V.row(F(f,1))+b(2)*V.row(F(f,2));
+    };
+
+    //traces one direction (sign=1 forward, -1 backward) of a streamline from its seed, sampling it every sampleSpacing
+    auto trace_half=[&](const int line, const double sign, int f, int m, Vector3d b){
+      RowVector3d p=point_at(f,b);
+      int entry=-1, zeroCrossings=0;
+      double arc=0.0;
+      double nextSample=(sign>0.0 ? 0.0 : sampleSpacing);  //the seed is sampled by the forward half
+      for (int crossing=0;(f!=-1)&&(crossing<maxCrossings)&&(zeroCrossings<maxZeroCrossings);crossing++){
+        double t, u;
+        const RowVector3d db=sign*data.baryField.block<1,3>(f,3*m);
+        const int k=streamline_face_exit(b, db, entry, t, u);
+        if (k==-1)
+          break;
+        Vector3d bExit=Vector3d::Zero();
+        bExit(k)=1.0-u;
+        bExit((k+1)%3)=u;
+        const RowVector3d pExit=(1.0-u)*V.row(F(f,k))+u*V.row(F(f,(k+1)%3));
+        const double length=(pExit-p).norm();
+        zeroCrossings=(length>0.0 ? 0 : zeroCrossings+1);
+        const RowVector3d tangent=(length>0.0 ? RowVector3d((pExit-p)/length) : RowVector3d(sign*data.field.block<1,3>(f,3*m)));
+
+        RowVector3d pEnd=pExit;
+        bool blocked=false;
+        for (;nextSample<=arc+length;nextSample+=sampleSpacing){
+          const double alpha=(length>0.0 ? (nextSample-arc)/length : 0.0);
+          const RowVector3d q=p+alpha*(pExit-p);
+          if (!grid.is_free(q, tangent, testDistance, cosThreshold, line, sign*nextSample, selfArc)){
+            pEnd=q;
+            blocked=true;
+            break;
+          }
+          grid.insert(q, tangent, line, sign*nextSample, f, b+alpha*(bExit-b));
+        }
+        if ((pEnd-p).squaredNorm()>0.0){
+          P1List.push_back(p);
+          P2List.push_back(pEnd);
+          lineList.push_back(line);
+        }
+        if (blocked)
+          break;
+
+        arc+=length;
+        p=pExit;
+        streamline_cross_edge(F, data, k, u, f, m, entry, b);
+      }
+    };
+
+    //the seed is always sampled, so that a line occupies its seed even when it cannot leave it forward
+    auto trace_line=[&](const int f, const int m, const Vector3d& b){
+      const int line=lineFirstSample.size();
+      lineFirstSample.push_back(grid.num_samples());
+      trace_half(line, 1.0, f, m, b);
+      if (grid.num_samples()==lineFirstSample[line])
+        grid.insert(point_at(f,b), data.field.block<1,3>(f,3*m), line, 0.0, f, b);
+      trace_half(line, -1.0, f, m, b);
+    };
+
+    //a zero (or non-finite) vector cannot be traced, and would pass every tangent test of the grid
+    auto is_valid_seed=[&](const int f, const int m, const Vector3d& b)->bool{
+      const double norm2=data.field.block<1,3>(f,3*m).squaredNorm();
+      if (!std::isfinite(norm2)||(norm2==0.0))
+        return false;
+      return grid.is_free(point_at(f,b), data.field.block<1,3>(f,3*m), separation, cosThreshold, -1, 0.0, selfArc);
+    };
+
+    //the vector of face f that is the most parallel to a tangent (as a line for even N)
+    auto closest_direction=[&](const int f, const RowVector3d& tangent)->int{
+      int bestM=0;
+      double bestDot=-2.0;
+      for (int m=0;m<N;m++){
+        double d=data.field.block<1,3>(f,3*m).dot(tangent);
+        if (N%2==0)
+          d=std::abs(d);
+        if (d>bestDot){
+          bestDot=d;
+          bestM=m;
+        }
+      }
+      return bestM;
+    };
+
+    //walks a distance on the mesh along a tangent vector, unfolding it across the edges; fails at the boundary
+    auto walk=[&](int& f, Vector3d& b, RowVector3d w, double distance)->bool{
+      int entry=-1, m=0;
+      for (int crossing=0;crossing<maxCrossings;crossing++){
+        RowVector3d db;
+        for (int i=0;i<3;i++)
+          db(i)=data.baryGradients.block<1,3>(f,3*i).dot(w);
+        double t, u;
+        const int k=streamline_face_exit(b, db, entry, t, u);
+        if (k==-1)
+          return false;
+        if (t>=distance){
+          b=(b+distance*db.transpose()).cwiseMax(0.0);
+          b/=b.sum();
+          return true;
+        }
+        distance-=t;
+        const RowVector3d e=(V.row(F(f,(k+1)%3))-V.row(F(f,k))).normalized();
+        const RowVector3d n0=mesh.FN.row(f);
+        streamline_cross_edge(F, data, k, u, f, m, entry, b);
+        if (f==-1)
+          return false;
+        const RowVector3d n1=mesh.FN.row(f);
+        w=w.dot(e)*e+w.dot(n0.cross(e))*n1.cross(e);
+      }
+      return false;
+    };
+
+    int currLine=0, nextFace=0;
+    while (true){
+      if (currLine<(int)lineFirstSample.size()){
+        //seeding from both sides of the next streamline
+        const int firstSample=lineFirstSample[currLine];
+        const int lastSample=(currLine+1<(int)lineFirstSample.size() ? lineFirstSample[currLine+1] : grid.num_samples());
+        for (int s=firstSample;s<lastSample;s++){
+          for (int side=-1;side<=1;side+=2){
+            int f=grid.faces[s];
+            Vector3d b=grid.barys[s];
+            const RowVector3d tangent=grid.tangents[s];
+            const RowVector3d n=mesh.FN.row(f);
+            RowVector3d w=n.cross(tangent);
+            if (w.squaredNorm()==0.0)
+              continue;
+            if (!walk(f, b, (double)side*w.normalized(), separation))
+              continue;
+            const int m=closest_direction(f, tangent);
+            if (is_valid_seed(f, m, b))
+              trace_line(f, m, b);
+          }
+        }
+        currLine++;
+        continue;
+      }
+
+      //a seed in a region that the streamlines have not reached (the same face is scanned again until it is covered)
+      bool found=false;
+      while ((nextFace<F.rows())&&(!found)){
+        const Vector3d b=Vector3d::Constant(1.0/3.0);
+        for (int m=0;(m<numFamilies)&&(!found);m++){
+          if (is_valid_seed(nextFace, m, b)){
+            const int numSamples=grid.num_samples();
+            trace_line(nextFace, m, b);
+            found=true;
+            if (grid.num_samples()==numSamples)  //nothing was traced, so nothing would stop the face from being seeded again
+              nextFace++;
+          }
+        }
+        if (!found)
+          nextFace++;
+      }
+      if (!found)
+        break;
+    }
+
+    P1.resize(P1List.size(),3);
+    P2.resize(P2List.size(),3);
+    lineIndices.resize(lineList.size());
+    for (size_t i=0;i<P1List.size();i++){
+      P1.row(i)=P1List[i];
+      P2.row(i)=P2List[i];
+      lineIndices(i)=lineList[i];
+    }
+  }
+
+
+  // Version with the separation ratio of Jobard and Lefer (testRatio=0.5)
+  IGL_INLINE void evenly_spaced_streamlines(const MeshTopology& mesh,
+                                            const Eigen::MatrixXd& rawField,
+                                            const double separation,
+                                            Eigen::MatrixXd& P1,
+                                            Eigen::MatrixXd& P2,
+                                            Eigen::VectorXi& lineIndices)
+  {
+    evenly_spaced_streamlines(mesh, rawField, separation, 0.5, P1, P2, lineIndices);
+  }
+}
+
+#endif
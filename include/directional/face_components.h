@@ -0,0 +1,70 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2021 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef DIRECTIONAL_FACE_COMPONENTS_H
+#define DIRECTIONAL_FACE_COMPONENTS_H
+
+#include <vector>
+#include <Eigen/Core>
+#include <igl/igl_inline.h>
+
+namespace directional
+{
+  // Labels the connected components of a mesh, where two faces are connected if they share an inner edge.
+  // The components are numbered in the order of their first face, so a connected mesh has all faces in component 0, and the first face of every component is its smallest face index.
+  // Input:
+  //   EF               #E by 2 edge-face adjacency (-1 on the boundary)
+  //   numFaces         #F
+  // Output:
+  //   faceComponents   #F the component of every face
+  //   returns the number of components
+  IGL_INLINE int face_components(const Eigen::MatrixXi& EF,
+                                 const int numFaces,
+                                 Eigen::VectorXi& faceComponents)
+  {
+    //union-find over the inner edges, always linking to the smaller root so that every root is the first face of its component
+    std::vector<int> parent(numFaces);
+    for (int i=0;i<numFaces;i++)
+      parent[i]=i;
+    for (int i=0;i<EF.rows();i++){
+      if ((EF(i,0)==-1)||(EF(i,1)==-1))
+        continue;
+      int r0=EF(i,0), r1=EF(i,1);
+      while (parent[r0]!=r0) r0=parent[r0]=parent[parent[r0]];
+      while (parent[r1]!=r1) r1=parent[r1]=parent[parent[r1]];
+      if (r0<r1)
+        parent[r1]=r0;
+      else if (r1<r0)
+        parent[r0]=r1;
+    }
+
+    //a parent always has a smaller index than its child, so one ascending pass labels everything
+    int numComponents=0;
+    faceComponents.resize(numFaces);
+    for (int i=0;i<numFaces;i++)
+      faceComponents(i)=(parent[i]==i ? numComponents++ : faceComponents(parent[i]));
+    return numComponents;
+  }
+
+
+  // The first face of every component, as labeled by face_components() (a convenient seed for traversals that are run per component).
+  // Input:
+  //   faceComponents   #F the component of every face
+  //   numComponents    the number of components
+  // Output:
+  //   componentSeeds   #components the smallest face index in every component
+  IGL_INLINE void component_seeds(const Eigen::VectorXi& faceComponents,
+                                  const int numComponents,
+                                  Eigen::VectorXi& componentSeeds)
+  {
+    componentSeeds=Eigen::VectorXi::Constant(numComponents,-1);
+    for (int i=faceComponents.size()-1;i>=0;i--)
+      componentSeeds(faceComponents(i))=i;
+  }
+}
+
+#endif
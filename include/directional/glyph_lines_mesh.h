@@ -13,9 +13,9 @@
 #include <igl/per_face_normals.h>
 #include <igl/avg_edge_length.h>
 #include <igl/colon.h>
-#include <igl/speye.h>
 #include <directional/representative_to_raw.h>
 #include <directional/angled_arrows.h>
+#include <directional/sample_faces.h>
 #include <Eigen/Core>
 
 
@@ -63,58 +63,9 @@ namespace directional
     igl::barycenter(V, F, barycenters);
     
     VectorXi sampledFaces;
-    if (sparsity!=0){
-      //creating adjacency matrix
-      vector<Triplet<int>> adjTris;
-      for (int i=0;i<EF.rows();i++)
-        if ((EF(i,0)!=-1)&&(EF(i,1)!=-1)){
-          adjTris.push_back(Triplet<int>(EF(i,0), EF(i,1),1));
-          adjTris.push_back(Triplet<int>(EF(i,1), EF(i,0),1));
-        }
-      
-      SparseMatrix<int> adjMat(F.rows(),F.rows());
-      adjMat.setFromTriplets(adjTris.begin(), adjTris.end());
-      SparseMatrix<int> newAdjMat(F.rows(),F.rows()),matMult;
-      igl::speye(F.rows(), F.rows(), matMult);
-      for (int i=0;i<sparsity;i++){
-        matMult=matMult*adjMat;
-        newAdjMat+=matMult;
-      }
-      
-      //cout<<"newAdjMat: "<<newAdjMat<<endl;
-      
-      adjMat=newAdjMat;
-      
-      vector<set<int>> ringAdjacencies(F.rows());
-      for (int k=0; k<adjMat.outerSize(); ++k){
-        for (SparseMatrix<int>::InnerIterator it(adjMat,k); it; ++it){
-          ringAdjacencies[it.row()].insert(it.col());
-          ringAdjacencies[it.col()].insert(it.row());
-        }
-      }
-      
-      VectorXi sampleMask=VectorXi::Zero(F.rows());
-      for (int i=0;i<F.rows();i++){
-        if (sampleMask(i)!=0) //occupied face
-          continue;
-        
-        sampleMask(i)=2;
-        //clearing out all other faces
-        for (set<int>::iterator si=ringAdjacencies[i].begin();si!=ringAdjacencies[i].end();si++){
-          if (sampleMask(*si)==0)
-            sampleMask(*si)=1;
-         
-        }
-      }
-      
-      vector<int> samplesList;
-      for (int i=0;i<sampleMask.size();i++)
-        if (sampleMask(i)==2)
-          samplesList.push_back(i);
-      
-      sampledFaces = Eigen::Map<Eigen::VectorXi, Eigen::Unaligned>(samplesList.data(), samplesList.size());
-      
-    } else igl::colon(0,1,F.rows()-1,sampledFaces);
+    if (sparsity!=0)
+      directional::sample_faces(F, EF, sparsity, sampledFaces);
+    else igl::colon(0,1,F.rows()-1,sampledFaces);
     
     MatrixXd vectNormals(sampledFaces.rows()*N,3);
     P1.resize(sampledFaces.rows() * N, 3);
@@ -125,7 +76,7 @@ namespace directional
     for (int i=0;i<sampledFaces.size();i++)
       for (int j=0;j<N;j++){
         P1.row(j*sampledFaces.size()+i) = barycenters.row(sampledFaces(i));
-        P2.row(j*sampledFaces.size()+i) = rawField.block(sampledFaces(i),j*3,1,3);
+        P2.row(j*sampledFaces.size()+i) = rawField.block<1,3>(sampledFaces(i),j*3);
         vectNormals.row(j*sampledFaces.size()+i) = normals.row(sampledFaces(i));
       }
     
@@ -47,7 +47,7 @@ namespace directional
   IGL_INLINE bool integrate(const Eigen::MatrixXd& wholeV,
                             const Eigen::MatrixXi& wholeF,
                             const Eigen::MatrixXi& FE,
-                            const Eigen::MatrixXd rawField,
+                            const Eigen::MatrixXd& rawField,
                             IntegrationData& intData,
                             const Eigen::MatrixXd& cutV,
                             const Eigen::MatrixXi& cutF,
@@ -339,6 +339,22 @@ namespace directional
     
   }
   
+  //Version with the combed field as a view (see directional::setup_integration()); it is materialized once, since the rounding keeps its own copy of the field.
+  IGL_INLINE bool integrate(const Eigen::MatrixXd& wholeV,
+                            const Eigen::MatrixXi& wholeF,
+                            const Eigen::MatrixXi& FE,
+                            const CombedFieldView& combedView,
+                            IntegrationData& intData,
+                            const Eigen::MatrixXd& cutV,
+                            const Eigen::MatrixXi& cutF,
+                            Eigen::MatrixXd& NFunction,
+                            Eigen::MatrixXd& NCornerFunctions)
+  {
+    Eigen::MatrixXd combedField;
+    combedView.materialize(combedField);
+    return integrate(wholeV, wholeF, FE, combedField, intData, cutV, cutF, NFunction, NCornerFunctions);
+  }
+  
 }
 
 #endif
@@ -27,8 +27,8 @@ namespace directional
   //  V   #V by 3 cylinder mesh coordinates
   //  T   #T by 3 mesh triangles
   //  C   #T by 3 face-based colors
-  IGL_INLINE bool line_cylinders(const Eigen::MatrixXd& P1,
-                                 const Eigen::MatrixXd& P2,
+  IGL_INLINE bool line_cylinders(const Eigen::Ref<const Eigen::MatrixXd>& P1,
+                                 const Eigen::Ref<const Eigen::MatrixXd>& P2,
                                  const double& radius,
                                  const Eigen::MatrixXd& cyndColors,
                                  const int res,
@@ -8,6 +8,8 @@
 
 
 #include <iostream>
+#include <algorithm>
+#include <igl/parallel_for.h>
 #include <igl/parallel_transport_angles.h>
 #include <igl/local_basis.h>
 #include <igl/edge_topology.h>
@@ -31,7 +33,10 @@ wCloseUnconstrained(1e-3),
 wCloseConstrained(100),
 redFactor_wsmooth(.8),
 gamma(0.1),
-tikh_gamma(1e-8)
+tikh_gamma(1e-8),
+iterativeSolve(false),
+cgMaxIter(1000),
+cgTolerance(1e-2)
 {}
 
 
@@ -45,36 +50,35 @@ namespace directional
 
     PolyCurlReductionSolverData &data;
     //Symbolic calculations
-    IGL_INLINE void rj_barrier_face(const Eigen::RowVectorXd &vec2D_a,
+    //The per-face and per-edge kernels work on fixed-size types (the 4 local coordinates of the two vectors of each face), so that they do not allocate, and can run in parallel.
+    //The Jacobian is only written if do_jac is true.
+    IGL_INLINE void rj_barrier_face(const Eigen::RowVector4d &vec2D_a,
                                     const double &s,
-                                    Eigen::VectorXd &residuals,
-                                    bool do_jac = false,
-                                    // Alec: why use a reference if it can
-                                    // point some undefined junk? This is asking
-                                    // for trouble...
-                                    Eigen::MatrixXd &J = *(Eigen::MatrixXd*)NULL);
-    IGL_INLINE void rj_polycurl_edge(const Eigen::RowVectorXd &vec2D_a,
+                                    Eigen::Matrix<double,1,1> &residuals,
+                                    bool do_jac,
+                                    Eigen::Matrix<double,1,4> &Jac);
+    IGL_INLINE void rj_polycurl_edge(const Eigen::RowVector4d &vec2D_a,
                                      const Eigen::RowVector2d &ea,
-                                     const Eigen::RowVectorXd &vec2D_b,
+                                     const Eigen::RowVector4d &vec2D_b,
                                      const Eigen::RowVector2d &eb,
-                                     Eigen::VectorXd &residuals,
-                                     bool do_jac = false,
-                                     Eigen::MatrixXd &Jac = *(Eigen::MatrixXd*)NULL);
-    IGL_INLINE void rj_quotcurl_edge_polyversion(const Eigen::RowVectorXd &vec2D_a,
+                                     Eigen::Matrix<double,2,1> &residuals,
+                                     bool do_jac,
+                                     Eigen::Matrix<double,2,8> &Jac);
+    IGL_INLINE void rj_quotcurl_edge_polyversion(const Eigen::RowVector4d &vec2D_a,
                                                  const Eigen::RowVector2d &ea,
-                                                 const Eigen::RowVectorXd &vec2D_b,
+                                                 const Eigen::RowVector4d &vec2D_b,
                                                  const Eigen::RowVector2d &eb,
-                                                 Eigen::VectorXd &residuals,
-                                                 bool do_jac = false,
-                                                 Eigen::MatrixXd &Jac = *(Eigen::MatrixXd*)NULL);
-    IGL_INLINE void rj_smoothness_edge(const Eigen::RowVectorXd &vec2D_a,
-                                       const Eigen::RowVectorXd &vec2D_b,
+                                                 Eigen::Matrix<double,1,1> &residuals,
+                                                 bool do_jac,
+                                                 Eigen::Matrix<double,1,8> &Jac);
+    IGL_INLINE void rj_smoothness_edge(const Eigen::RowVector4d &vec2D_a,
+                                       const Eigen::RowVector4d &vec2D_b,
                                        const double &k,
                                        const int nA,
                                        const int nB,
-                                       Eigen::VectorXd &residuals,
-                                       bool do_jac = false,
-                                       Eigen::MatrixXd &Jac = *(Eigen::MatrixXd*)NULL);
+                                       Eigen::Matrix<double,4,1> &residuals,
+                                       bool do_jac,
+                                       Eigen::Matrix<double,4,8> &Jac);
 
   public:
     IGL_INLINE PolyCurlReductionSolver(PolyCurlReductionSolverData &cffsoldata);
@@ -87,6 +91,13 @@ namespace directional
                                      const Eigen::VectorXd &x_initial,
                                      Eigen::VectorXd &x);
 
+    //Solves Jac^T*Jac*direction = rhs by block-Jacobi preconditioned conjugate gradients, without forming Jac^T*Jac
+    //Returns whether the relative residual reached tolerance within maxIter iterations.
+    IGL_INLINE bool solvePCG(const Eigen::VectorXd &rhs,
+                             const double tolerance,
+                             const int maxIter,
+                             Eigen::VectorXd &direction);
+
     //Compute residuals and Jacobian for Gauss Newton
     IGL_INLINE double RJ(const Eigen::VectorXd &x,
                          const Eigen::VectorXd &x0,
@@ -264,8 +275,9 @@ IGL_INLINE void directional::PolyCurlReductionSolverData::computeInteriorEdges()
 
 }
 
+template <typename DerivedJ>
 IGL_INLINE void directional::PolyCurlReductionSolverData::add_Jacobian_to_svector(const int &toplace,
-                                                                                  const Eigen::MatrixXd &tJac,
+                                                                                  const Eigen::MatrixBase<DerivedJ> &tJac,
                                                                                   Eigen::VectorXd &SS_Jac)
 {
   int numInnerRows = tJac.rows();
@@ -445,13 +457,30 @@ IGL_INLINE void directional::PolyCurlReductionSolverData::computeJacobianPattern
                        II_Jac,
                        JJ_Jac);
   igl::sparse(II_Jac, JJ_Jac, SS_Jac, Jac);
+
+  //the slot of every Jacobian element in Jac.valuePtr()
+  Jac.makeCompressed();
+  jacSlots.resize(numJacElements);
+  for (int i = 0; i<numJacElements; ++i)
+  {
+    const int* colBegin = Jac.innerIndexPtr()+Jac.outerIndexPtr()[JJ_Jac(i)];
+    const int* colEnd = Jac.innerIndexPtr()+Jac.outerIndexPtr()[JJ_Jac(i)+1];
+    jacSlots[i] = std::lower_bound(colBegin, colEnd, II_Jac(i)) - Jac.innerIndexPtr();
+  }
+
+  //the solver-specific structures are rebuilt on first use
+  Hess.resize(0,0);
+  jacRowStart.clear();
 }
 
 
 
 IGL_INLINE void directional::PolyCurlReductionSolverData::computeHessianPattern()
 {
+  //the pairs of Jacobian elements in the same row; pair (ii,jj) contributes SS_Jac(ii)*SS_Jac(jj) to Hess(JJ_Jac(ii),JJ_Jac(jj))
   //II_Jac is sorted in ascending order already
+  std::vector<int> pairs1, pairs2;
+  std::vector<Eigen::Triplet<double> > Hess_triplets;
   int starti = 0;
   int currI = II_Jac(0);
   for (int ii = 0; ii<II_Jac.rows(); ++ii)
@@ -467,11 +496,11 @@ IGL_INLINE void directional::PolyCurlReductionSolverData::computeHessianPattern(
       int k2  = II_Jac(jj);
       if (k1 !=k2)
         break;
-      indInSS_Hess_1_vec.push_back(ii);
-      indInSS_Hess_2_vec.push_back(jj);
+      pairs1.push_back(ii);
+      pairs2.push_back(jj);
       Hess_triplets.push_back(Eigen::Triplet<double> (JJ_Jac(ii),
                                                       JJ_Jac(jj),
-                                                      SS_Jac(ii)*SS_Jac(jj)
+                                                      1.0
                                                       )
                               );
     }
@@ -479,19 +508,133 @@ IGL_INLINE void directional::PolyCurlReductionSolverData::computeHessianPattern(
   Hess.resize(Jac.cols(),Jac.cols());
   Hess.setFromTriplets(Hess_triplets.begin(), Hess_triplets.end());
   Hess.makeCompressed();
+
+  //the slot of every pair in Hess.valuePtr() (the row indices of every column are sorted), and the pairs grouped by slot
+  std::vector<int> pairSlots(pairs1.size());
+  for (size_t p = 0; p<pairs1.size(); ++p)
+  {
+    int col = JJ_Jac(pairs2[p]);
+    const int* colBegin = Hess.innerIndexPtr()+Hess.outerIndexPtr()[col];
+    const int* colEnd = Hess.innerIndexPtr()+Hess.outerIndexPtr()[col+1];
+    pairSlots[p] = std::lower_bound(colBegin, colEnd, JJ_Jac(pairs1[p])) - Hess.innerIndexPtr();
+  }
+  hessSlotStart.assign(Hess.nonZeros()+1, 0);
+  for (size_t p = 0; p<pairs1.size(); ++p)
+    hessSlotStart[pairSlots[p]+1]++;
+  for (int k = 0; k<Hess.nonZeros(); ++k)
+    hessSlotStart[k+1] += hessSlotStart[k];
+  std::vector<int> fill(hessSlotStart.begin(), hessSlotStart.end()-1);
+  indInSS_Hess_1_vec.resize(pairs1.size());
+  indInSS_Hess_2_vec.resize(pairs1.size());
+  for (size_t p = 0; p<pairs1.size(); ++p)
+  {
+    indInSS_Hess_1_vec[fill[pairSlots[p]]] = pairs1[p];
+    indInSS_Hess_2_vec[fill[pairSlots[p]]++] = pairs2[p];
+  }
+  computeNewHessValues();
 }
 
 
 
 IGL_INLINE void directional::PolyCurlReductionSolverData::computeNewHessValues()
 {
-  for (int i =0; i<Hess_triplets.size(); ++i)
-    Hess_triplets[i] = Eigen::Triplet<double>(Hess_triplets[i].row(),
-                                              Hess_triplets[i].col(),
-                                              SS_Jac(indInSS_Hess_1_vec[i])*SS_Jac(indInSS_Hess_2_vec[i])
-                                              );
+  //every column only writes its own values, so the columns are independent
+  double* hessValues = Hess.valuePtr();
+  const int* hessOuter = Hess.outerIndexPtr();
+  igl::parallel_for(Hess.outerSize(), [&](const int col)
+  {
+    for (int k = hessOuter[col]; k<hessOuter[col+1]; ++k)
+    {
+      double value = 0.;
+      for (int p = hessSlotStart[k]; p<hessSlotStart[k+1]; ++p)
+        value += SS_Jac(indInSS_Hess_1_vec[p])*SS_Jac(indInSS_Hess_2_vec[p]);
+      hessValues[k] = value;
+    }
+  }, 1000);
+}
 
-  Hess.setFromTriplets(Hess_triplets.begin(), Hess_triplets.end());
+
+
+IGL_INLINE void directional::PolyCurlReductionSolverData::computeMatrixFreePattern()
+{
+  //II_Jac is sorted in ascending order, so the rows are contiguous
+  jacRowStart.assign(num_residuals+1, 0);
+  for (int i = 0; i<numJacElements; ++i)
+    jacRowStart[II_Jac(i)+1]++;
+  for (int i = 0; i<num_residuals; ++i)
+    jacRowStart[i+1] += jacRowStart[i];
+
+  //every row holds 4 or 8 elements, and every 4 consecutive ones are the variables 4*fi..4*fi+3 of a single face fi
+  faceSegmentStart.assign(numF+1, 0);
+  for (int i = 0; i<numJacElements; i+=4)
+    faceSegmentStart[JJ_Jac(i)/4+1]++;
+  for (int fi = 0; fi<numF; ++fi)
+    faceSegmentStart[fi+1] += faceSegmentStart[fi];
+  faceSegments.resize(numJacElements/4);
+  std::vector<int> fill(faceSegmentStart.begin(), faceSegmentStart.end()-1);
+  for (int i = 0; i<numJacElements; i+=4)
+    faceSegments[fill[JJ_Jac(i)/4]++] = i;
+
+  precondBlocks.resize(4*numF, 4);
+}
+
+
+
+IGL_INLINE void directional::PolyCurlReductionSolverData::computePreconditioner(const double regularization)
+{
+  igl::parallel_for(numF, [&](const int fi)
+  {
+    Eigen::Matrix4d block = regularization*Eigen::Matrix4d::Identity();
+    for (int s = faceSegmentStart[fi]; s<faceSegmentStart[fi+1]; ++s)
+    {
+      Eigen::Vector4d segment = SS_Jac.segment<4>(faceSegments[s]);
+      block += segment*segment.transpose();
+    }
+    precondBlocks.block<4,4>(4*fi, 0) = block.inverse();
+  }, 1000);
+}
+
+
+
+IGL_INLINE void directional::PolyCurlReductionSolverData::multiplyJac(const Eigen::VectorXd &v,
+                                                                      Eigen::VectorXd &Jv)
+{
+  Jv.resize(num_residuals);
+  igl::parallel_for(num_residuals, [&](const int i)
+  {
+    double value = 0.;
+    for (int k = jacRowStart[i]; k<jacRowStart[i+1]; ++k)
+      value += SS_Jac(k)*v(JJ_Jac(k));
+    Jv(i) = value;
+  }, 1000);
+}
+
+
+
+IGL_INLINE void directional::PolyCurlReductionSolverData::multiplyJacTranspose(const Eigen::VectorXd &w,
+                                                                               Eigen::VectorXd &JTw)
+{
+  //every face only writes its own 4 variables
+  JTw.resize(numVariables);
+  igl::parallel_for(numF, [&](const int fi)
+  {
+    Eigen::Vector4d value = Eigen::Vector4d::Zero();
+    for (int s = faceSegmentStart[fi]; s<faceSegmentStart[fi+1]; ++s)
+      value += w(II_Jac(faceSegments[s]))*SS_Jac.segment<4>(faceSegments[s]);
+    JTw.segment<4>(4*fi) = value;
+  }, 1000);
+}
+
+
+
+IGL_INLINE void directional::PolyCurlReductionSolverData::applyPreconditioner(const Eigen::VectorXd &r,
+                                                                              Eigen::VectorXd &z)
+{
+  z.resize(numVariables);
+  igl::parallel_for(numF, [&](const int fi)
+  {
+    z.segment<4>(4*fi) = precondBlocks.block<4,4>(4*fi, 0)*r.segment<4>(4*fi);
+  }, 1000);
 }
 
 
@@ -535,6 +678,19 @@ IGL_INLINE void directional::PolyCurlReductionSolver::solveGaussNewton(polycurl_
   double F;
   Eigen::VectorXd xprev = x;
   Eigen::VectorXd xc = igl::slice(x_initial, data.constrained, 1);
+
+  if (params.iterativeSolve)
+  {
+    if (data.jacRowStart.empty())
+      data.computeMatrixFreePattern();
+  }
+  else if (data.Hess.rows()==0)
+  {
+    data.computeHessianPattern();
+    data.solver.analyzePattern(data.Hess);
+  }
+
+  double rhsNorm0 = 0.;
   //  double ESmooth, EClose, ECurl, EQuotCurl, EBarrier;
   for (int innerIter = 0; innerIter<params.numIter; ++innerIter)
   {
@@ -561,23 +717,41 @@ IGL_INLINE void directional::PolyCurlReductionSolver::solveGaussNewton(polycurl_
 
     converged = false;
 
-    Eigen::VectorXd rhs = data.Jac.transpose()*data.residuals;
-
-    bool success;
-    data.solver.factorize(data.Hess);
-    success = data.solver.info() == Eigen::Success;
+    Eigen::VectorXd rhs;
+    Eigen::VectorXd direction;
+    if (!params.iterativeSolve)
+    {
+      rhs = data.Jac.transpose()*data.residuals;
 
-    if(!success)
-      std::cerr<<"PolyCurlReductionSolver -- Could not do LU"<<std::endl;
+      bool success;
+      data.solver.factorize(data.Hess);
+      success = data.solver.info() == Eigen::Success;
 
-    Eigen::VectorXd direction;
+      if(!success)
+        std::cerr<<"PolyCurlReductionSolver -- Could not do LU"<<std::endl;
 
-    double error;
-    direction = data.solver.solve(rhs);
-    error = (data.Hess*direction - rhs).cwiseAbs().maxCoeff();
-    if(error> 1e-4)
+      double error;
+      direction = data.solver.solve(rhs);
+      error = (data.Hess*direction - rhs).cwiseAbs().maxCoeff();
+      if(error> 1e-4)
+      {
+        std::cerr<<"PolyCurlReductionSolver -- Could not solve"<<std::endl;
+      }
+    }
+    else
     {
-      std::cerr<<"PolyCurlReductionSolver -- Could not solve"<<std::endl;
+      data.multiplyJacTranspose(data.residuals, rhs);
+      data.computePreconditioner(params.tikh_gamma);
+
+      //inexact Newton: the steps are solved more accurately as the gradient decreases
+      if (innerIter==0)
+        rhsNorm0 = rhs.norm();
+      double tolerance = params.cgTolerance;
+      if (rhsNorm0>0)
+        tolerance = std::min(tolerance, std::sqrt(rhs.norm()/rhsNorm0));
+
+      if(!solvePCG(rhs, tolerance, params.cgMaxIter, direction))
+        std::cerr<<"PolyCurlReductionSolver -- Conjugate gradients did not converge"<<std::endl;
     }
 
     // adaptive backtracking
@@ -625,6 +799,46 @@ IGL_INLINE void directional::PolyCurlReductionSolver::solveGaussNewton(polycurl_
 }
 
 
+IGL_INLINE bool directional::PolyCurlReductionSolver::solvePCG(const Eigen::VectorXd &rhs,
+                                                               const double tolerance,
+                                                               const int maxIter,
+                                                               Eigen::VectorXd &direction)
+{
+  direction.setZero(rhs.size());
+  double rhsNorm = rhs.norm();
+  if (rhsNorm==0)
+    return true;
+
+  Eigen::VectorXd r = rhs;
+  Eigen::VectorXd z, p, Jp, Hp;
+  data.applyPreconditioner(r, z);
+  p = z;
+  double rz = r.dot(z);
+  for (int i = 0; i<maxIter; ++i)
+  {
+    //p^T*Jac^T*Jac*p = |Jac*p|^2
+    data.multiplyJac(p, Jp);
+    double pHp = Jp.squaredNorm();
+    if (pHp<=0)
+      return false;
+    data.multiplyJacTranspose(Jp, Hp);
+
+    double alpha = rz/pHp;
+    direction += alpha*p;
+    r -= alpha*Hp;
+    if (r.norm()<=tolerance*rhsNorm)
+      return true;
+
+    data.applyPreconditioner(r, z);
+    double rzNew = r.dot(z);
+    p = z+(rzNew/rz)*p;
+    rz = rzNew;
+  }
+  return false;
+}
+
+
+
 IGL_INLINE double directional::PolyCurlReductionSolver::RJ(const Eigen::VectorXd &x,
                                                            const Eigen::VectorXd &x0,
                                                            const polycurl_reduction_parameters &params,
@@ -665,10 +879,12 @@ IGL_INLINE double directional::PolyCurlReductionSolver::RJ(const Eigen::VectorXd
   //quotcurl
   RJ_QuotCurl(sol2D, sqrt(params.wQuotCurl), startRowInJacobian, doJacs, startIndexInVectors);
 
-  if(doJacs)
+  //the iterative solver works directly on SS_Jac
+  if(doJacs && !params.iterativeSolve)
   {
+    double* jacValues = data.Jac.valuePtr();
     for (int i =0; i<data.numJacElements; ++i)
-      data.Jac.coeffRef(data.II_Jac(i), data.JJ_Jac(i)) = data.SS_Jac(i);
+      jacValues[data.jacSlots[i]] = data.SS_Jac(i);
     data.computeNewHessValues();
   }
 
@@ -678,21 +894,17 @@ IGL_INLINE double directional::PolyCurlReductionSolver::RJ(const Eigen::VectorXd
 
 
 
-IGL_INLINE void directional::PolyCurlReductionSolver::rj_smoothness_edge(const Eigen::RowVectorXd &vec2D_a,
-                                                                         const Eigen::RowVectorXd &vec2D_b,
+IGL_INLINE void directional::PolyCurlReductionSolver::rj_smoothness_edge(const Eigen::RowVector4d &vec2D_a,
+                                                                         const Eigen::RowVector4d &vec2D_b,
                                                                          const double &k,
                                                                          const int nA,
                                                                          const int nB,
-                                                                         Eigen::VectorXd &residuals,
+                                                                         Eigen::Matrix<double,4,1> &residuals,
                                                                          bool do_jac,
-                                                                         Eigen::MatrixXd &Jac)
+                                                                         Eigen::Matrix<double,4,8> &Jac)
 {
-  const Eigen::RowVector2d &ua = vec2D_a.segment(0, 2);
-  const Eigen::RowVector2d &va = vec2D_a.segment(2, 2);
-  const Eigen::RowVector2d &ub = vec2D_b.segment(0, 2);
-  const Eigen::RowVector2d &vb = vec2D_b.segment(2, 2);
-  const double &xua=ua[0], &yua=ua[1], &xva=va[0], &yva=va[1];
-  const double &xub=ub[0], &yub=ub[1], &xvb=vb[0], &yvb=vb[1];
+  const double &xua=vec2D_a[0], &yua=vec2D_a[1], &xva=vec2D_a[2], &yva=vec2D_a[3];
+  const double &xub=vec2D_b[0], &yub=vec2D_b[1], &xvb=vec2D_b[2], &yvb=vec2D_b[3];
 
   double xua_2 = xua*xua;
   double xva_2 = xva*xva;
@@ -728,7 +940,6 @@ IGL_INLINE void directional::PolyCurlReductionSolver::rj_smoothness_edge(const E
   double t19 = (t10*t9 - 4*t5*t7);
 
 
-  residuals.resize(4, 1);
   residuals <<
   cA*(t10 + t9) - sA*(t13) - t12 - t11,
   sA*(t10 + t9) - 2*t8 - 2*t6 + cA*(t13),
@@ -743,7 +954,6 @@ IGL_INLINE void directional::PolyCurlReductionSolver::rj_smoothness_edge(const E
     double t22 = 2*yva*t10 + 4*t5*yua;
     double t23 = 2*xva*t10 - 4*t1*yva;
 
-    Jac.resize(4,8);
     Jac <<                                                                     2*xua*cA - 2*yua*sA,                                                                     - 2*yua*cA - 2*xua*sA,                                                                     2*xva*cA - 2*yva*sA,                                                                     - 2*yva*cA - 2*xva*sA,                                  -2*xub,                                 2*yub,                                  -2*xvb,                                 2*yvb,
     2*yua*cA + 2*xua*sA,                                                                       2*xua*cA - 2*yua*sA,                                                                     2*yva*cA + 2*xva*sA,                                                                       2*xva*cA - 2*yva*sA,                                  -2*yub,                                -2*xub,                                  -2*yvb,                                -2*xvb,
     cB*(t21) - sB*(t20), - cB*(t20) - sB*(t21), cB*(t23) - sB*(t22), - cB*(t22) - sB*(t23),   4*xvb*t4 - 2*xub*t11, 2*yub*t11 + 4*t3*yvb,   4*xub*t4 - 2*xvb*t12, 2*yvb*t12 + 4*t3*yub,
@@ -761,7 +971,8 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_Smoothness(const Eigen:
 {
   if (wSmoothSqrt ==0)
     return;
-  for (int ii=0; ii<data.numInteriorEdges; ++ii)
+  //every edge writes its own rows and Jacobian entries, so the edges are independent
+  igl::parallel_for(data.numInteriorEdges, [&](const int ii)
   {
     // the two faces of the flap
     int a = data.E2F_int(ii,0);
@@ -769,8 +980,8 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_Smoothness(const Eigen:
 
     int k = data.indInteriorToFull[ii];
 
-    Eigen::MatrixXd tJac;
-    Eigen::VectorXd tRes;
+    Eigen::Matrix<double,4,8> tJac;
+    Eigen::Matrix<double,4,1> tRes;
     rj_smoothness_edge(sol2D.row(a),
                        sol2D.row(b),
                        data.K[k],
@@ -788,21 +999,19 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_Smoothness(const Eigen:
       int startIndex = startIndexInVectors+data.numInnerJacRows_smooth*data.numInnerJacCols_edge*ii;
       data.add_Jacobian_to_svector(startIndex, wSmoothSqrt*tJac,data.SS_Jac);
     }
-  }
+  }, 1000);
 }
 
 
 
-IGL_INLINE void directional::PolyCurlReductionSolver::rj_barrier_face(const Eigen::RowVectorXd &vec2D_a,
+IGL_INLINE void directional::PolyCurlReductionSolver::rj_barrier_face(const Eigen::RowVector4d &vec2D_a,
                                                                       const double &s,
-                                                                      Eigen::VectorXd &residuals,
+                                                                      Eigen::Matrix<double,1,1> &residuals,
                                                                       bool do_jac,
-                                                                      Eigen::MatrixXd &Jac)
+                                                                      Eigen::Matrix<double,1,4> &Jac)
 {
 
-  const Eigen::RowVector2d &ua = vec2D_a.segment(0, 2);
-  const Eigen::RowVector2d &va = vec2D_a.segment(2, 2);
-  const double &xua=ua[0], &yua=ua[1], &xva=va[0], &yva=va[1];
+  const double &xua=vec2D_a[0], &yua=vec2D_a[1], &xva=vec2D_a[2], &yva=vec2D_a[3];
 
 
   double xva_2 = xva*xva;
@@ -820,8 +1029,7 @@ IGL_INLINE void directional::PolyCurlReductionSolver::rj_barrier_face(const Eige
   double t05_3 = t05*t05_2;
 
   if (do_jac)
-    Jac.setZero(1,4);
-  residuals.resize(1, 1);
+    Jac.setZero();
   if (t05>=s)
     residuals << 0;
   else if (t05<0)
@@ -852,10 +1060,10 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_Barrier(const Eigen::Ma
   if (wBarrierSqrt ==0)
     return;
 
-  for (int fi=0; fi<data.numF; ++fi)
+  igl::parallel_for(data.numF, [&](const int fi)
   {
-    Eigen::MatrixXd tJac;
-    Eigen::VectorXd tRes;
+    Eigen::Matrix<double,1,4> tJac;
+    Eigen::Matrix<double,1,1> tRes;
     rj_barrier_face(sol2D.row(fi),
                     s,
                     tRes,
@@ -870,7 +1078,7 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_Barrier(const Eigen::Ma
       int startIndex = startIndexInVectors+data.numInnerJacRows_barrier*data.numInnerJacCols_face*fi;
       data.add_Jacobian_to_svector(startIndex, wBarrierSqrt*tJac,data.SS_Jac);
     }
-  }
+  }, 1000);
 }
 
 
@@ -884,7 +1092,7 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_Closeness(const Eigen::
 {
   if (wCloseUnconstrainedSqrt ==0 && wCloseConstrainedSqrt ==0)
     return;
-  for (int fi=0; fi<data.numF; ++fi)
+  igl::parallel_for(data.numF, [&](const int fi)
   {
     Eigen::Vector4d weights;
     if (!data.is_constrained_face[fi])
@@ -899,38 +1107,30 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_Closeness(const Eigen::
         weights.setConstant(wCloseConstrainedSqrt);
     }
 
-    Eigen::MatrixXd tJac;
-    Eigen::VectorXd tRes;
-    tJac = Eigen::MatrixXd::Identity(4,4);
-    tRes.resize(4, 1); tRes<<(sol2D.row(fi)-sol02D.row(fi)).transpose();
+    Eigen::Vector4d tRes = (sol2D.row(fi)-sol02D.row(fi)).transpose();
     int startRow = startRowInJacobian+data.numInnerJacRows_close*fi;
     data.residuals.segment(startRow,data.numInnerJacRows_close) = weights.array()*tRes.array();
 
     if(doJacs)
     {
       int startIndex = startIndexInVectors+data.numInnerJacRows_close*data.numInnerJacCols_face*fi;
-      data.add_Jacobian_to_svector(startIndex, weights.asDiagonal()*tJac,data.SS_Jac);
+      data.add_Jacobian_to_svector(startIndex, Eigen::Matrix4d(weights.asDiagonal()),data.SS_Jac);
     }
-
-  }
+  }, 1000);
 }
 
 
 
-IGL_INLINE void directional::PolyCurlReductionSolver::rj_polycurl_edge(const Eigen::RowVectorXd &vec2D_a,
+IGL_INLINE void directional::PolyCurlReductionSolver::rj_polycurl_edge(const Eigen::RowVector4d &vec2D_a,
                                                                        const Eigen::RowVector2d &ea,
-                                                                       const Eigen::RowVectorXd &vec2D_b,
+                                                                       const Eigen::RowVector4d &vec2D_b,
                                                                        const Eigen::RowVector2d &eb,
-                                                                       Eigen::VectorXd &residuals,
+                                                                       Eigen::Matrix<double,2,1> &residuals,
                                                                        bool do_jac,
-                                                                       Eigen::MatrixXd &Jac)
+                                                                       Eigen::Matrix<double,2,8> &Jac)
 {
-  const Eigen::RowVector2d &ua = vec2D_a.segment(0, 2);
-  const Eigen::RowVector2d &va = vec2D_a.segment(2, 2);
-  const Eigen::RowVector2d &ub = vec2D_b.segment(0, 2);
-  const Eigen::RowVector2d &vb = vec2D_b.segment(2, 2);
-  const double &xua=ua[0], &yua=ua[1], &xva=va[0], &yva=va[1];
-  const double &xub=ub[0], &yub=ub[1], &xvb=vb[0], &yvb=vb[1];
+  const double &xua=vec2D_a[0], &yua=vec2D_a[1], &xva=vec2D_a[2], &yva=vec2D_a[3];
+  const double &xub=vec2D_b[0], &yub=vec2D_b[1], &xvb=vec2D_b[2], &yvb=vec2D_b[3];
   const double &xea=ea[0], &yea=ea[1];
   const double &xeb=eb[0], &yeb=eb[1];
 
@@ -944,7 +1144,6 @@ IGL_INLINE void directional::PolyCurlReductionSolver::rj_polycurl_edge(const Eig
   const double dub_2 = dub*dub;
   const double dvb_2 = dvb*dvb;
 
-  residuals.resize(2, 1);
   residuals << dua_2 - dub_2 + dva_2 - dvb_2,
   dua_2*dva_2 - dub_2*dvb_2 ;
 
@@ -953,7 +1152,6 @@ IGL_INLINE void directional::PolyCurlReductionSolver::rj_polycurl_edge(const Eig
   if (do_jac)
   {
 
-    Jac.resize(2,8);
     Jac << 2*xea*dua,                       2*yea*dua,                       2*xea*dva,                       2*yea*dva,                       -2*xeb*dub,                       -2*yeb*dub,                       -2*xeb*dvb,                       -2*yeb*dvb,
     2*xea*dua*dva_2, 2*yea*dua*dva_2, 2*xea*dua_2*dva, 2*yea*dua_2*dva, -2*xeb*dub*dvb_2, -2*yeb*dub*dvb_2, -2*xeb*dub_2*dvb, -2*yeb*dub_2*dvb;
   }
@@ -969,7 +1167,7 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_Curl(const Eigen::Matri
 {
   if((wCASqrt==0) &&(wCBSqrt==0))
     return;
-  for (int ii=0; ii<data.numInteriorEdges; ++ii)
+  igl::parallel_for(data.numInteriorEdges, [&](const int ii)
   {
     // the two faces of the flap
     int a = data.E2F_int(ii,0);
@@ -990,8 +1188,8 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_Curl(const Eigen::Matri
     Eigen::RowVector2d eb; eb<<xeb, yeb;
 
 
-    Eigen::MatrixXd tJac;
-    Eigen::VectorXd tRes;
+    Eigen::Matrix<double,2,8> tJac;
+    Eigen::Matrix<double,2,1> tRes;
     rj_polycurl_edge(sol2D.row(a),
                      ea,
                      sol2D.row(b),
@@ -1014,26 +1212,21 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_Curl(const Eigen::Matri
       int startIndex = startIndexInVectors+data.numInnerJacRows_polycurl*data.numInnerJacCols_edge*ii;
       data.add_Jacobian_to_svector(startIndex, tJac,data.SS_Jac);
     }
-
-  }
+  }, 1000);
 }
 
 
 
-IGL_INLINE void directional::PolyCurlReductionSolver::rj_quotcurl_edge_polyversion(const Eigen::RowVectorXd &vec2D_a,
+IGL_INLINE void directional::PolyCurlReductionSolver::rj_quotcurl_edge_polyversion(const Eigen::RowVector4d &vec2D_a,
                                                                                    const Eigen::RowVector2d &ea,
-                                                                                   const Eigen::RowVectorXd &vec2D_b,
+                                                                                   const Eigen::RowVector4d &vec2D_b,
                                                                                    const Eigen::RowVector2d &eb,
-                                                                                   Eigen::VectorXd &residuals,
+                                                                                   Eigen::Matrix<double,1,1> &residuals,
                                                                                    bool do_jac,
-                                                                                   Eigen::MatrixXd &Jac)
+                                                                                   Eigen::Matrix<double,1,8> &Jac)
 {
-  const Eigen::RowVector2d &ua = vec2D_a.segment(0, 2);
-  const Eigen::RowVector2d &va = vec2D_a.segment(2, 2);
-  const Eigen::RowVector2d &ub = vec2D_b.segment(0, 2);
-  const Eigen::RowVector2d &vb = vec2D_b.segment(2, 2);
-  const double &xua=ua[0], &yua=ua[1], &xva=va[0], &yva=va[1];
-  const double &xub=ub[0], &yub=ub[1], &xvb=vb[0], &yvb=vb[1];
+  const double &xua=vec2D_a[0], &yua=vec2D_a[1], &xva=vec2D_a[2], &yva=vec2D_a[3];
+  const double &xub=vec2D_b[0], &yub=vec2D_b[1], &xvb=vec2D_b[2], &yvb=vec2D_b[3];
   const double &xea=ea[0], &yea=ea[1];
   const double &xeb=eb[0], &yeb=eb[1];
 
@@ -1050,12 +1243,10 @@ IGL_INLINE void directional::PolyCurlReductionSolver::rj_quotcurl_edge_polyversi
   double t01 = (dua_2 - dva_2);
 
 
-  residuals.resize(1, 1);
   residuals << dua*dva*t00 - dub*dvb*t01;
 
   if (do_jac)
   {
-    Jac.resize(1,8);
     Jac <<  xea*dva*t00 - 2*xea*dua*dub*dvb, yea*dva*t00 - 2*yea*dua*dub*dvb, xea*dua*t00 + 2*xea*dub*dva*dvb, yea*dua*t00 + 2*yea*dub*dva*dvb, 2*xeb*dua*dub*dva - xeb*dvb*t01, 2*yeb*dua*dub*dva - yeb*dvb*t01, - xeb*dub*t01 - 2*xeb*dua*dva*dvb, - yeb*dub*t01 - 2*yeb*dua*dva*dvb;
   }
 }
@@ -1067,7 +1258,7 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_QuotCurl(const Eigen::M
                                                                   bool doJacs,
                                                                   const int startIndexInVectors)
 {
-  for (int ii=0; ii<data.numInteriorEdges; ++ii)
+  igl::parallel_for(data.numInteriorEdges, [&](const int ii)
   {
     // the two faces of the flap
     int a = data.E2F_int(ii,0);
@@ -1088,8 +1279,8 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_QuotCurl(const Eigen::M
     Eigen::RowVector2d eb; eb<<xeb, yeb;
 
 
-    Eigen::MatrixXd tJac;
-    Eigen::VectorXd tRes;
+    Eigen::Matrix<double,1,8> tJac;
+    Eigen::Matrix<double,1,1> tRes;
     rj_quotcurl_edge_polyversion(sol2D.row(a),
                                  ea,
                                  sol2D.row(b),
@@ -1106,7 +1297,7 @@ IGL_INLINE void directional::PolyCurlReductionSolver::RJ_QuotCurl(const Eigen::M
       int startIndex = startIndexInVectors+data.numInnerJacRows_quotcurl*data.numInnerJacCols_edge*ii;
       data.add_Jacobian_to_svector(startIndex, wQuotCurlSqrt*tJac,data.SS_Jac);
     }
-  }
+  }, 1000);
 }
 
 
@@ -1121,8 +1312,6 @@ IGL_INLINE void directional::polycurl_reduction_precompute(const Eigen::MatrixXd
   data.precomputeMesh(V,F);
 
   data.computeJacobianPattern();
-  data.computeHessianPattern();
-  data.solver.analyzePattern(data.Hess);
 
   data.initializeConstraints(b,bc,constraintLevel);
   Eigen::MatrixXd twoVectorMat=original_field.block(0,0,original_field.rows(),6);
@@ -97,6 +97,13 @@ struct directional::polycurl_reduction_parameters
   double gamma;
   //tikhonov regularization term (typically not needed, default value should suffice)
   double tikh_gamma;
+  //solve the Gauss-Newton steps with matrix-free preconditioned conjugate gradients instead of factorizing Jac^T*Jac.
+  //The factorization is faster for small meshes, but its fill-in runs out of memory for meshes of millions of faces.
+  bool iterativeSolve;
+  //the maximum number of conjugate-gradient iterations per Gauss-Newton step (iterativeSolve only)
+  int cgMaxIter;
+  //the relative residual at which conjugate gradients stop; it is tightened as the gradient decreases (inexact Newton, iterativeSolve only)
+  double cgTolerance;
 
   IGL_INLINE polycurl_reduction_parameters();
 
@@ -169,8 +176,9 @@ public:
                                         const int &numInnerCols,
                                         Eigen::VectorXi &rows,
                                         Eigen::VectorXi &columns);
+  template <typename DerivedJ>
   IGL_INLINE void add_Jacobian_to_svector(const int &toplace,
-                                          const Eigen::MatrixXd &tJac,
+                                          const Eigen::MatrixBase<DerivedJ> &tJac,
                                           Eigen::VectorXd &SS_Jac);
 
   IGL_INLINE void add_jac_indices_edge(const int numInnerRows,
@@ -188,11 +196,20 @@ public:
                                         const int &numInnerCols,
                                         Eigen::VectorXi &rows,
                                         Eigen::VectorXi &columns);
+  std::vector<int> jacSlots;  //the position of every Jacobian element (SS_Jac) in Jac.valuePtr()
+  //The Hessian (Jac^T*Jac) is only formed by the direct solver, and its pattern is built by computeHessianPattern() on first use. Its values are accumulated in place:
+  //value k of Hess (in Hess.valuePtr()) is the sum of SS_Jac(indInSS_Hess_1_vec[p])*SS_Jac(indInSS_Hess_2_vec[p]) over p in [hessSlotStart[k], hessSlotStart[k+1]).
   std::vector<int> indInSS_Hess_1_vec;
   std::vector<int> indInSS_Hess_2_vec;
+  std::vector<int> hessSlotStart;
   Eigen::SparseMatrix<double> Hess;
-  std::vector<Eigen::Triplet<double> > Hess_triplets;
   Eigen::SimplicialLDLT<Eigen::SparseMatrix<double> > solver;
+  //The iterative solver applies Jac and Jac^T directly through SS_Jac, where every row is made of 4-element segments on the 4 variables of a single face.
+  //The structure is built by computeMatrixFreePattern() on first use.
+  std::vector<int> jacRowStart;       //the elements of residual i are [jacRowStart[i], jacRowStart[i+1]) in SS_Jac
+  std::vector<int> faceSegmentStart;  //the segments of face f are faceSegments[faceSegmentStart[f]..faceSegmentStart[f+1])
+  std::vector<int> faceSegments;      //the start of every segment in SS_Jac
+  Eigen::MatrixXd precondBlocks;      //#F*4 by 4 the inverse of the 4x4 diagonal block of Jac^T*Jac of every face (block-Jacobi preconditioner)
 
   IGL_INLINE void precomputeMesh(const Eigen::MatrixXd &_V,
                                  const Eigen::MatrixXi &_F);
@@ -200,6 +217,11 @@ public:
   IGL_INLINE void computeJacobianPattern();
   IGL_INLINE void computeHessianPattern();
   IGL_INLINE void computeNewHessValues();
+  IGL_INLINE void computeMatrixFreePattern();
+  IGL_INLINE void computePreconditioner(const double regularization);
+  IGL_INLINE void multiplyJac(const Eigen::VectorXd &v, Eigen::VectorXd &Jv);
+  IGL_INLINE void multiplyJacTranspose(const Eigen::VectorXd &w, Eigen::VectorXd &JTw);
+  IGL_INLINE void applyPreconditioner(const Eigen::VectorXd &r, Eigen::VectorXd &z);
   IGL_INLINE void initializeOriginalVariable(const Eigen::MatrixXd& originalField);
   IGL_INLINE void initializeConstraints(const Eigen::VectorXi& b,
                                         const Eigen::MatrixXd& bc,
@@ -8,6 +8,7 @@
 
 #include "polyroots.h"
 #include <Eigen/Eigenvalues>
+#include <algorithm>
 
 template <typename S, typename T>
 IGL_INLINE void igl::polyRoots(Eigen::Matrix<S, Eigen::Dynamic,1> &polyCoeff, //real or comples coefficients
@@ -30,6 +31,35 @@ IGL_INLINE void igl::polyRoots(Eigen::Matrix<S, Eigen::Dynamic,1> &polyCoeff, //
 }
 
 
+template <typename S, typename T, int m>
+IGL_INLINE void igl::polyRoots(const Eigen::Matrix<S, m, 1> &polyCoeff,
+                               Eigen::Matrix<std::complex<T>, m-1, 1> &roots)
+{
+  //companion matrix
+  Eigen::Matrix<S, m-1, m-1> a; a.setZero();
+  a.row(0) = -polyCoeff.template tail<m-1>().transpose()/polyCoeff(0);
+  for (int i = 1; i<m-1; ++i)
+    a(i,i-1) = 1.;
+  roots = a.eigenvalues();
+  std::sort(roots.data(), roots.data() + roots.size(), [](std::complex<T> a, std::complex<T> b){return arg(a) < arg(b);});
+}
+
+
+template <typename T>
+IGL_INLINE void igl::biquadraticRoots(const std::complex<T> &a,
+                                      const std::complex<T> &b,
+                                      Eigen::Matrix<std::complex<T>, 4, 1> &roots)
+{
+  //y^2 + a*y + b = 0, in the form that does not cancel: y1 = q/2, y2 = 2b/q
+  std::complex<T> sqrtDisc = std::sqrt(a*a-T(4)*b);
+  std::complex<T> q = (real(conj(a)*sqrtDisc)>=0 ? -a-sqrtDisc : -a+sqrtDisc);
+  std::complex<T> y1 = q/T(2);
+  std::complex<T> y2 = (q==std::complex<T>(0) ? std::complex<T>(0) : T(2)*b/q);
+  roots << std::sqrt(y1), -std::sqrt(y1), std::sqrt(y2), -std::sqrt(y2);
+  std::sort(roots.data(), roots.data() + roots.size(), [](std::complex<T> a, std::complex<T> b){return arg(a) < arg(b);});
+}
+
+
 
 #ifdef IGL_STATIC_LIBRARY
 // Explicit template instantiation
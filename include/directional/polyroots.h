@@ -28,6 +28,25 @@ namespace igl {
   IGL_INLINE void polyRoots(Eigen::Matrix<S, Eigen::Dynamic,1> &polyCoeff, //real or comples coefficients
                             Eigen::Matrix<std::complex<T>, Eigen::Dynamic,1> &roots // complex roots (double or float)
                             );
+
+  // The same for a polynomial of fixed degree (m-1), with the companion matrix on the stack, so that it does not allocate and can run per face in parallel.
+  // Inputs:
+  //   polyCoeff      m coefficients, highest degree first
+  // Output:
+  //   roots          m-1 complex roots, sorted by argument
+  template <typename S, typename T, int m>
+  IGL_INLINE void polyRoots(const Eigen::Matrix<S, m, 1> &polyCoeff,
+                            Eigen::Matrix<std::complex<T>, m-1, 1> &roots);
+
+  // Closed-form roots of x^4 + a*x^2 + b (the vectors of a 4-PolyVector with coefficients a and b), as the square roots of the roots of y^2 + a*y + b.
+  // Inputs:
+  //   a, b           complex coefficients
+  // Output:
+  //   roots          4 complex roots, sorted by argument (as in polyRoots)
+  template <typename T>
+  IGL_INLINE void biquadraticRoots(const std::complex<T> &a,
+                                   const std::complex<T> &b,
+                                   Eigen::Matrix<std::complex<T>, 4, 1> &roots);
 }
 
 
@@ -21,8 +21,13 @@
 #include <igl/speye.h>
 #include <igl/eigs.h>
 #include <iostream>
+#include <memory>
+#include <algorithm>
+#include <igl/parallel_for.h>
 #include <directional/circumcircle.h>
-#include <directional/complex_eigs.h>
+#include <directional/smallest_eigenvector.h>
+#include <directional/MeshTopology.h>
+#include <directional/face_components.h>
 
 namespace directional
 {
@@ -31,9 +36,16 @@ namespace directional
 #define BARYCENTRIC_WEIGHTS 1
 #define INV_COT_WEIGHTS 2
 
-  struct PolyVectorData{
+  // The operators, parameters, and cached factorizations of a polyvector field design problem.
+  // Scalar is the precision of the operators and of the solves (PolyVectorDataf for single precision, which halves the memory of the cached matrices and factorizations). The geometry (V, B1, B2) and the user parameters are always in double.
+  template<typename Scalar>
+  struct PolyVectorDataT{
   public:
     
+    typedef std::complex<Scalar> Complex;
+    typedef Eigen::Matrix<Complex, Eigen::Dynamic, 1> VectorXc;
+    typedef Eigen::Matrix<Complex, Eigen::Dynamic, Eigen::Dynamic> MatrixXc;
+    
     //User parameters
     Eigen::VectorXi constFaces;   //list of faces where there are (partial) constraints. The faces can repeat to constrain more vectors
     Eigen::MatrixXd constVectors; //corresponding to constFaces.
@@ -48,21 +60,164 @@ namespace directional
     
     int lapType;                  //Choice of weights (from UNIFORM_WEIGHTS,BARYCENTRIC_WEIGHTS or INV_COT_WEIGHTS)
     
-    Eigen::SparseMatrix<std::complex<double>> smoothMat;    //Smoothness energy
-    Eigen::SparseMatrix<std::complex<double>> roSyMat;      //Rotational-symmetry energy
-    Eigen::SparseMatrix<std::complex<double>> alignMat;     //(soft) alignment energy.
-    Eigen::SparseMatrix<std::complex<double>> reducMat;     //reducing the fixed dofs (for instance with sign symmetry or fixed partial constraints)
-    Eigen::VectorXcd reducRhs;                                   //The uncompressed PV coeffs are reducMat*true_dofs+reducRhs
-    Eigen::VectorXcd alignRhs;                                   //encoding the soft constraints
+    Eigen::SparseMatrix<Complex> smoothMat;    //Smoothness energy
+    Eigen::SparseMatrix<Complex> roSyMat;      //Rotational-symmetry energy
+    Eigen::SparseMatrix<Complex> alignMat;     //(soft) alignment energy.
+    Eigen::SparseMatrix<Complex> reducMat;     //reducing the fixed dofs (for instance with sign symmetry or fixed partial constraints)
+    VectorXc reducRhs;                         //The uncompressed PV coeffs are reducMat*true_dofs+reducRhs
+    VectorXc alignRhs;                         //encoding the soft constraints
     
     //Mass and stiffness matrices
-    Eigen::SparseMatrix<std::complex<double>> WSmooth, WAlign, WRoSy, M;
+    Eigen::SparseMatrix<Complex> WSmooth, WAlign, WRoSy, M;
     double totalRoSyWeight, totalConstrainedWeight, totalSmoothWeight;    //for co-scaling energies
+    Eigen::VectorXd faceAreas;    //#F face areas (used for the alignment weights)
+    int numComponents;            //number of connected components of the mesh, which are solved independently
+    Eigen::VectorXi faceComponents;  //#F the component of every face (see directional::face_components)
+    
+    //Unweighted quadratic forms of each energy (e.g., smoothMat^H*WSmooth*smoothMat)
+    Eigen::SparseMatrix<Complex> smoothLhs, roSyLhs, alignLhs;
+    
+    //The reduced system and its factorizations, assembled by polyvector_field() and reused by subsequent calls.
+    //It is derived from the operators above, and is therefore mutable (polyvector_field() takes a const PolyVectorData). A copy of a PolyVectorData starts with an empty cache, which is rebuilt on its first solve.
+    struct SolveCache{
+      VectorXc fixedRhs;                         //reducMat^H*(total energy)*reducRhs (the contribution of the fixed dofs)
+      VectorXc totalRhs;
+      Eigen::SimplicialLDLT<Eigen::SparseMatrix<Complex>> solver;
+      bool patternAnalyzed;         //The blocks and the symbolic factorizations of the reduced system reducMat^H*(total energy)*reducMat are valid (its sparsity pattern only changes in polyvector_precompute())
+      bool lhsFactorized;           //The numeric factorizations are valid
+      bool rhsAssembled;            //totalRhs is valid
+      double factorWSmooth, factorWRoSy;  //The weights with which the reduced system was factorized
+      
+      //Decoupled solve: every connected component of the mesh, and (when the reduced system does not tie different polynomial coefficients) every coefficient, is an independent system, and they are factorized and solved in parallel.
+      typedef Eigen::SimplicialLDLT<Eigen::SparseMatrix<Complex>, Eigen::Lower, Eigen::NaturalOrdering<int>> BlockSolver;
+      std::vector<Eigen::VectorXi> blockDofs;     //the reduced dofs of each independent block (empty when the system is coupled)
+      std::vector<Eigen::VectorXi> blockRows;     //the unreduced coefficients that the dofs of each block span
+      Eigen::VectorXi rowBlock, rowLocal;         //the block of each unreduced coefficient (-1 for fixed ones), and its index within blockRows
+      std::vector<Eigen::SparseMatrix<Complex>> blockReducMats;  //the restriction of reducMat to blockRows x blockDofs
+      std::vector<Eigen::PermutationMatrix<Eigen::Dynamic,Eigen::Dynamic,int>> blockPerms;   //fill-reducing ordering of each block (computed on the first factorization, and shared by blocks with the same pattern)
+      std::vector<std::unique_ptr<BlockSolver>> blockSolvers;
+      
+      //On a mesh with several components, the eigenvector of an unconstrained field is found per component (otherwise it concentrates on one of them)
+      std::vector<Eigen::VectorXi> componentFaces;  //the faces of every component
+      std::vector<std::unique_ptr<SmallestEigDataT<Scalar>>> componentEigData;
+      
+      SolveCache(){invalidate();}
+      SolveCache(const SolveCache&){invalidate();}
+      SolveCache& operator=(const SolveCache&){invalidate(); return *this;}
+      
+      void invalidate()
+      {
+        patternAnalyzed=lhsFactorized=rhsAssembled=false;
+        blockDofs.clear();
+        blockRows.clear();
+        blockReducMats.clear();
+        blockPerms.clear();
+        blockSolvers.clear();
+        componentEigData.clear();
+      }
+    };
+    mutable SolveCache cache;
     
-    PolyVectorData():signSymmetry(true), lapType(BARYCENTRIC_WEIGHTS), wSmooth(1.0), wRoSy(0.0) {wAlignment.resize(0); constFaces.resize(0); constVectors.resize(0,3);}
-    ~PolyVectorData(){}
+    //Unconstrained fields: smallest eigenvector of the smoothness energy, with its shift-invert factorization cached (it only depends on the mesh). On a mesh with several components, it only holds the parameters (tolerance, etc.) of the per-component eigenvectors.
+    mutable SmallestEigDataT<Scalar> eigData;
+    
+    PolyVectorDataT():signSymmetry(true), lapType(BARYCENTRIC_WEIGHTS), wSmooth(1.0), wRoSy(0.0), numComponents(1) {wAlignment.resize(0); constFaces.resize(0); constVectors.resize(0,3);}
+    ~PolyVectorDataT(){}
   };
   
+  typedef PolyVectorDataT<double> PolyVectorData;
+  typedef PolyVectorDataT<float> PolyVectorDataf;
+  
+  
+  // Computes the soft-alignment operators (for constraints with wAlignment>=0) from pvData.constVectors and pvData.wAlignment.
+  // Called by polyvector_precompute(), and can be called on its own when only the targets or the weights of the soft constraints change; in that case polyvector_field() reuses the cached factorization when possible.
+  // The constrained faces, and which of the constraints are hard, must remain the same as in the last polyvector_precompute().
+  // Inputs:
+  //  B1, B2: #F by 3 matrices representing the local base of each face.
+  //  pvData: a structure on which polyvector_precompute() has been called.
+  // Outputs:
+  //  pvData: updated alignment operators
+  template<typename Scalar>
+  IGL_INLINE void polyvector_update_alignment(const Eigen::MatrixXd& B1,
+                                              const Eigen::MatrixXd& B2,
+                                              PolyVectorDataT<Scalar>& pvData)
+  {
+    using namespace std;
+    using namespace Eigen;
+    typedef complex<Scalar> Complex;
+    typedef typename PolyVectorDataT<Scalar>::VectorXc VectorXc;
+    
+    int N = pvData.N;
+    int realN = (pvData.signSymmetry ? N/2 : N);
+    realN = (pvData.wRoSy < 0.0 ? 1 : realN);
+    int jump = (pvData.signSymmetry ? 2 : 1);
+    jump = (pvData.wRoSy < 0.0 ? pvData.N : jump);
+    
+    int rowCounter=0;
+    vector<Triplet<Complex>> alignTriplets;
+    vector<VectorXcd> alignRhsList;
+    vector<Triplet<Complex>> WAlignTriplets;
+    pvData.totalConstrainedWeight=0.0;
+    bool noSoftAlignment = true;
+    for (int i=0;i<pvData.constFaces.size();i++){
+      if (pvData.wAlignment(i)<0.0)
+        continue;  //here we only handle soft alignments
+      
+      noSoftAlignment=false;
+      
+      complex<double> constVectorComplexSingle=std::complex<double>(pvData.constVectors.row(i).dot(B1.row(pvData.constFaces(i))), pvData.constVectors.row(i).dot(B2.row(pvData.constFaces(i))));
+      complex<double> constVectorComplex = (pvData.signSymmetry ? constVectorComplexSingle*constVectorComplexSingle : constVectorComplexSingle);
+      constVectorComplex = (pvData.wRoSy < 0.0 ? pow(constVectorComplexSingle, N) : constVectorComplex);
+      
+      MatrixXcd singleReducMat=MatrixXcd::Zero(realN,realN-1);
+      VectorXcd singleReducRhs=VectorXcd::Zero(realN);
+      for (int j=0;j<realN-1;j++){
+        singleReducMat(j,j)=-constVectorComplex;
+        singleReducMat(j+1,j)=complex<double>(1.0,0.0);
+      }
+      singleReducRhs(realN-1) = -constVectorComplex;
+      
+      MatrixXcd IAiA;
+      if (realN>1){
+        MatrixXcd invSingleReducMat = singleReducMat.completeOrthogonalDecomposition().pseudoInverse();
+        IAiA = MatrixXcd::Identity(realN,realN) - singleReducMat*invSingleReducMat;
+      } else IAiA = MatrixXcd::Ones(realN,realN);
+      singleReducRhs = IAiA*singleReducRhs;
+      for (int j=0;j<IAiA.rows();j++)
+        for (int k=0;k<IAiA.cols();k++)
+          alignTriplets.push_back(Triplet<Complex>(rowCounter+j, k*jump*pvData.sizeF+pvData.constFaces(i), Complex(IAiA(j,k))));
+      
+      alignRhsList.push_back(singleReducRhs);
+      for (int j=0;j<singleReducRhs.size();j++){
+        WAlignTriplets.push_back(Triplet<Complex>(rowCounter+j, rowCounter+j, Complex(pvData.wAlignment(i)*pvData.faceAreas(pvData.constFaces(i)))));
+        pvData.totalConstrainedWeight+=pvData.faceAreas(pvData.constFaces(i));
+      }
+      rowCounter+=realN;
+    }
+    
+    if (noSoftAlignment)
+      pvData.totalConstrainedWeight=1.0;  //it wouldn't be used, except just to avoid a division by zero in the energy formulation
+  
+    pvData.alignRhs.resize(rowCounter);
+    for (int i=0;i<alignRhsList.size();i++)
+      pvData.alignRhs.segment(i*realN,realN)=alignRhsList[i].template cast<Complex>();
+    
+    pvData.alignMat.resize(rowCounter, N*pvData.sizeF);
+    pvData.alignMat.setFromTriplets(alignTriplets.begin(), alignTriplets.end());
+    
+    SparseMatrix<Complex> WAlign(rowCounter,rowCounter);
+    WAlign.setFromTriplets(WAlignTriplets.begin(), WAlignTriplets.end());
+    
+    //When there is a single dof per face, the alignment operator does not depend on the targets, and the factorization is only invalidated by a change of weights.
+    bool sameWeights = (WAlign.rows()==pvData.WAlign.rows()) && (VectorXc(WAlign.diagonal())==VectorXc(pvData.WAlign.diagonal()));
+    if ((realN>1)||(!sameWeights))
+      pvData.cache.lhsFactorized=false;
+    pvData.cache.rhsAssembled=false;
+    
+    pvData.WAlign=WAlign;
+    pvData.alignLhs=pvData.alignMat.adjoint()*pvData.WAlign*pvData.alignMat;
+  }
+  
   
   // Precalculate the operators according to the user-prescribed parameters. Must be called whenever any of them changes
   // Inputs:
@@ -74,6 +229,7 @@ namespace directional
   //  PolyVectorData (must fill non-default values in advance)
   // Outputs:
   //  PolyVectorData:       Updated structure with all operators
+  template<typename Scalar>
   IGL_INLINE void polyvector_precompute(const Eigen::MatrixXd& V,
                                         const Eigen::MatrixXi& F,
                                         const Eigen::MatrixXi& EV,
@@ -81,20 +237,27 @@ namespace directional
                                         const Eigen::MatrixXd& B1,
                                         const Eigen::MatrixXd& B2,
                                         const int N,
-                                        PolyVectorData& pvData)
+                                        PolyVectorDataT<Scalar>& pvData)
   {
     
     using namespace std;
     using namespace Eigen;
+    typedef complex<Scalar> Complex;
+    typedef typename PolyVectorDataT<Scalar>::VectorXc VectorXc;
     
     
     //Building the smoothness matrices, with an energy term for each inner edge and degree
     int rowCounter=0;
-    std::vector< Triplet<complex<double> > > dTriplets, WTriplets;
+    std::vector< Triplet<Complex> > dTriplets, WTriplets;
     pvData.N = N;
     pvData.sizeF = F.rows();
     if (pvData.N%2!=0) pvData.signSymmetry=false;  //it has to be for odd N
     
+    //invalidating the cached system
+    pvData.cache.invalidate();
+    pvData.eigData.factorized=false;
+    pvData.numComponents=face_components(EF, F.rows(), pvData.faceComponents);
+    
     /************Smoothness matrices****************/
     VectorXd stiffnessWeights=VectorXd::Zero(EF.rows());
     
@@ -121,9 +284,10 @@ namespace directional
     
     pvData.totalSmoothWeight = stiffnessWeights.sum();
     
-    vector<Triplet<complex<double>>> WSmoothTriplets, MTriplets;
+    vector<Triplet<Complex>> WSmoothTriplets, MTriplets;
     VectorXd doubleAreas;
     igl::doublearea(V,F,doubleAreas);
+    pvData.faceAreas=doubleAreas/2.0;
     for (int n = 0; n < pvData.N; n++)
     {
       for (int i=0;i<EF.rows();i++)
@@ -139,16 +303,16 @@ namespace directional
         complex<double> eg(veg(0), veg(1));
         
         // Add the term conj(f)^n*ui - conj(g)^n*uj to the differential matrix
-        dTriplets.push_back(Triplet<complex<double> >(rowCounter, n*F.rows()+EF(i,0), pow(conj(ef), pvData.N-n)));
-        dTriplets.push_back(Triplet<complex<double> >(rowCounter, n*F.rows()+EF(i,1), -1.*pow(conj(eg), pvData.N-n)));
+        dTriplets.push_back(Triplet<Complex>(rowCounter, n*F.rows()+EF(i,0), Complex(pow(conj(ef), pvData.N-n))));
+        dTriplets.push_back(Triplet<Complex>(rowCounter, n*F.rows()+EF(i,1), Complex(-1.*pow(conj(eg), pvData.N-n))));
         
         //stiffness weights
-        WSmoothTriplets.push_back(Triplet<complex<double> >(rowCounter, rowCounter, stiffnessWeights(i)));
+        WSmoothTriplets.push_back(Triplet<Complex>(rowCounter, rowCounter, Complex(stiffnessWeights(i))));
         rowCounter++;
       }
       
       for (int i=0;i<F.rows();i++)
-        MTriplets.push_back(Triplet<complex<double>>(n*F.rows()+i, n*F.rows()+i, doubleAreas(i)/2.0));
+        MTriplets.push_back(Triplet<Complex>(n*F.rows()+i, n*F.rows()+i, Complex(doubleAreas(i)/2.0)));
     }
     
     pvData.smoothMat.resize(rowCounter, pvData.N*F.rows());
@@ -156,6 +320,7 @@ namespace directional
     
     pvData.WSmooth.resize(rowCounter, rowCounter);
     pvData.WSmooth.setFromTriplets(WSmoothTriplets.begin(), WSmoothTriplets.end());
+    pvData.smoothLhs=pvData.smoothMat.adjoint()*pvData.WSmooth*pvData.smoothMat;
     
     pvData.M.resize(pvData.N*F.rows(), pvData.N*F.rows());
     pvData.M.setFromTriplets(MTriplets.begin(), MTriplets.end());
@@ -204,17 +369,18 @@ namespace directional
     
     //creating the global reduction matrices
     double colCounter=0;
-    pvData.reducRhs=VectorXcd::Zero(pvData.N*F.rows());
-    vector<Triplet<complex<double>>> reducMatTriplets;
+    pvData.reducRhs=VectorXc::Zero(pvData.N*F.rows());
+    vector<Triplet<Complex>> reducMatTriplets;
     int jump = (pvData.signSymmetry ? 2 : 1);
     jump = (pvData.wRoSy < 0.0 ? pvData.N : jump);
     for (int i=0;i<F.rows();i++){
       //std::cout<<"localFaceReducMats[i]: "<<localFaceReducMats[i]<<std::endl;
       for (int j=0;j<pvData.N;j+=jump){
         for (int k=0;k<localFaceReducMats[i].cols();k++)
-          reducMatTriplets.push_back(Triplet<complex<double>>(j*F.rows()+i, colCounter+k, localFaceReducMats[i](j/jump,k)));
+          if (localFaceReducMats[i](j/jump,k)!=complex<double>(0.0,0.0))  //only the structural nonzeros, from which the decoupled blocks are found
+            reducMatTriplets.push_back(Triplet<Complex>(j*F.rows()+i, colCounter+k, Complex(localFaceReducMats[i](j/jump,k))));
         
-        pvData.reducRhs(j*F.rows()+i) = localFaceReducRhs[i](j/jump);
+        pvData.reducRhs(j*F.rows()+i) = Complex(localFaceReducRhs[i](j/jump));
       }
      
       colCounter+=localFaceReducMats[i].cols();
@@ -227,10 +393,10 @@ namespace directional
     /****************rotational-symmetry matrices********************/
     
     if (pvData.wRoSy >= 0.0){ //this is anyhow enforced, this matrix is unnecessary)
-      vector<Triplet<complex<double>>> roSyTriplets, WRoSyTriplets;
+      vector<Triplet<Complex>> roSyTriplets, WRoSyTriplets;
       for (int i=F.rows();i<pvData.N*F.rows();i++){
-        roSyTriplets.push_back(Triplet<complex<double>>(i,i,1.0));
-        WRoSyTriplets.push_back(Triplet<complex<double>>(i,i,doubleAreas(i%F.rows())/2.0));
+        roSyTriplets.push_back(Triplet<Complex>(i,i,Complex(1.0)));
+        WRoSyTriplets.push_back(Triplet<Complex>(i,i,Complex(doubleAreas(i%F.rows())/2.0)));
       }
       
       pvData.roSyMat.resize(N*F.rows(), N*F.rows());
@@ -245,120 +411,363 @@ namespace directional
       pvData.WRoSy.resize(0,0);  //Eeven necessary?
       pvData.totalRoSyWeight=1.0;
     }
+    pvData.roSyLhs=pvData.roSyMat.adjoint()*pvData.WRoSy*pvData.roSyMat;
     
     /*****************Soft alignment matrices*******************/
-    rowCounter=0;
-    vector<Triplet<complex<double>>> alignTriplets;
-    vector<VectorXcd> alignRhsList;
-    vector<Triplet<complex<double>>> WAlignTriplets;
-    pvData.totalConstrainedWeight=0.0;
-    bool noSoftAlignment = true;
-    for (int i=0;i<pvData.constFaces.size();i++){
-      if (pvData.wAlignment(i)<0.0)
-        continue;  //here we only handle soft alignments
-      
-      noSoftAlignment=false;
-      
-      complex<double> constVectorComplexSingle=std::complex<double>(pvData.constVectors.row(i).dot(B1.row(pvData.constFaces(i))), pvData.constVectors.row(i).dot(B2.row(pvData.constFaces(i))));
-      complex<double> constVectorComplex = (pvData.signSymmetry ? constVectorComplexSingle*constVectorComplexSingle : constVectorComplexSingle);
-      constVectorComplex = (pvData.wRoSy < 0.0 ? pow(constVectorComplexSingle, N) : constVectorComplex);
-      numFaceConstraints(pvData.constFaces(i))++;
-      //faceConstraints(pvData.constFaces(i), numFaceConstraints(pvData.constFaces(i))++) = constVectorComplex;
-      
-      MatrixXcd singleReducMat=MatrixXcd::Zero(realN,realN-1);
-      VectorXcd singleReducRhs=VectorXcd::Zero(realN);
-      for (int j=0;j<realN-1;j++){
-        singleReducMat(j,j)=-constVectorComplex;
-        singleReducMat(j+1,j)=complex<double>(1.0,0.0);
+    pvData.WAlign.resize(0,0);
+    polyvector_update_alignment(B1, B2, pvData);
+  }
+
+
+  // Version with a precomputed mesh topology (see directional::MeshTopology)
+  template<typename Scalar>
+  IGL_INLINE void polyvector_precompute(const MeshTopology& mesh,
+                                        const int N,
+                                        PolyVectorDataT<Scalar>& pvData)
+  {
+    polyvector_precompute(mesh.V, mesh.F, mesh.EV, mesh.EF, mesh.B1, mesh.B2, N, pvData);
+  }
+  
+  // Version with a precomputed mesh topology (see directional::MeshTopology)
+  template<typename Scalar>
+  IGL_INLINE void polyvector_update_alignment(const MeshTopology& mesh,
+                                              PolyVectorDataT<Scalar>& pvData)
+  {
+    polyvector_update_alignment(mesh.B1, mesh.B2, pvData);
+  }
+
+
+  // Detects whether the reduced system in pvData decouples into independent blocks, from the sparsity structure of the operators alone (so that the blocks do not change with the weights).
+  // Different connected components of the mesh are never coupled. Within a component, every polynomial coefficient is a block of its own when no reduced dof (a row of reducMat^T) and no energy term (a row of smoothMat, roSyMat, or alignMat) spans several coefficients:
+  // that is, no soft alignment with more than one dof per face, and hard constraints only on fully-constrained faces. Smoothness and RoSy energies never couple coefficients.
+  // Inputs:
+  //  pvData: on which polyvector_precompute() has been called.
+  // Outputs:
+  //  pvData: blockDofs, blockRows, rowBlock, rowLocal, blockReducMats and blockSolvers are filled if the system decouples to at least two blocks, and are empty otherwise. blockPerms are computed on the first factorization.
+  template<typename Scalar>
+  IGL_INLINE void polyvector_analyze_blocks(const PolyVectorDataT<Scalar>& pvData)
+  {
+    using namespace std;
+    using namespace Eigen;
+    typedef complex<Scalar> Complex;
+    typedef typename PolyVectorDataT<Scalar>::SolveCache::BlockSolver BlockSolver;
+    typename PolyVectorDataT<Scalar>::SolveCache& cache = pvData.cache;
+    
+    cache.blockDofs.clear();
+    cache.blockRows.clear();
+    cache.blockReducMats.clear();
+    cache.blockPerms.clear();
+    cache.blockSolvers.clear();
+    cache.rowBlock.resize(0);
+    cache.rowLocal.resize(0);
+    
+    //the coefficient and the component of each reduced dof
+    bool coeffsCoupled=false;
+    VectorXi dofCoeff=VectorXi::Constant(pvData.reducMat.cols(),-1);
+    VectorXi dofComponent=VectorXi::Constant(pvData.reducMat.cols(),-1);
+    for (int k=0; k<pvData.reducMat.outerSize(); ++k)
+      for (typename SparseMatrix<Complex>::InnerIterator it(pvData.reducMat,k); it; ++it){
+        int currCoeff = it.row()/pvData.sizeF;
+        int currComponent = pvData.faceComponents(it.row()%pvData.sizeF);
+        if ((dofComponent(k)!=-1)&&(dofComponent(k)!=currComponent))
+          return;  //a dof spans several components (should not happen)
+        if ((dofCoeff(k)!=-1)&&(dofCoeff(k)!=currCoeff))
+          coeffsCoupled=true;  //a dof spans several coefficients
+        dofCoeff(k)=currCoeff;
+        dofComponent(k)=currComponent;
       }
-      singleReducRhs(realN-1) = -constVectorComplex;
-      
-      MatrixXcd IAiA;
-      if (realN>1){
-        MatrixXcd invSingleReducMat = singleReducMat.completeOrthogonalDecomposition().pseudoInverse();
-        IAiA = MatrixXcd::Identity(realN,realN) - singleReducMat*invSingleReducMat;
-      } else IAiA = MatrixXcd::Ones(realN,realN);
-      singleReducRhs = IAiA*singleReducRhs;
-      for (int j=0;j<IAiA.rows();j++)
-        for (int k=0;k<IAiA.cols();k++)
-          alignTriplets.push_back(Triplet<complex<double>>(rowCounter+j, k*jump*F.rows()+pvData.constFaces(i), IAiA(j,k)));
-      
-      alignRhsList.push_back(singleReducRhs);
-      for (int j=0;j<singleReducRhs.size();j++){
-        WAlignTriplets.push_back(Triplet<complex<double>>(rowCounter+j, rowCounter+j, pvData.wAlignment(i)*doubleAreas(pvData.constFaces(i))/2.0));
-        pvData.totalConstrainedWeight+=doubleAreas(pvData.constFaces(i))/2.0;
+    
+    //the energy terms E, where the quadratic form is E^H*W*E
+    const SparseMatrix<Complex>* energyMats[3]={&pvData.smoothMat, &pvData.roSyMat, &pvData.alignMat};
+    for (int m=0;(m<3)&&(!coeffsCoupled);m++){
+      const SparseMatrix<Complex>& E = *energyMats[m];
+      VectorXi termCoeff=VectorXi::Constant(E.rows(),-1);
+      for (int k=0; k<E.outerSize(); ++k)
+        for (typename SparseMatrix<Complex>::InnerIterator it(E,k); it; ++it){
+          if ((termCoeff(it.row())!=-1)&&(termCoeff(it.row())!=k/pvData.sizeF))
+            coeffsCoupled=true;
+          termCoeff(it.row())=k/pvData.sizeF;
+        }
+    }
+    
+    vector<int> key2block(pvData.N*pvData.numComponents,-1);
+    vector<vector<int>> blockDofsList;
+    VectorXi dofBlock(dofCoeff.size()), dofLocal(dofCoeff.size());
+    for (int i=0;i<dofCoeff.size();i++){
+      if (dofCoeff(i)==-1)
+        return;  //an unused dof (should not happen)
+      int key=(coeffsCoupled ? 0 : dofCoeff(i))*pvData.numComponents+dofComponent(i);
+      if (key2block[key]==-1){
+        key2block[key]=blockDofsList.size();
+        blockDofsList.push_back(vector<int>());
       }
-      rowCounter+=realN;
+      dofBlock(i)=key2block[key];
+      dofLocal(i)=blockDofsList[dofBlock(i)].size();
+      blockDofsList[dofBlock(i)].push_back(i);
     }
     
-    if (noSoftAlignment)
-      pvData.totalConstrainedWeight=1.0;  //it wouldn't be used, except just to avoid a division by zero in the energy formulation
+    if (blockDofsList.size()<2)  //nothing to gain
+      return;
+    
+    //the coefficients spanned by every block, and the restriction of the reduction to them
+    int numBlocks=blockDofsList.size();
+    vector<vector<int>> blockRowsList(numBlocks);
+    vector<vector<Triplet<Complex>>> blockReducTriplets(numBlocks);
+    cache.rowBlock=VectorXi::Constant(pvData.reducMat.rows(),-1);
+    cache.rowLocal=VectorXi::Constant(pvData.reducMat.rows(),-1);
+    for (int k=0; k<pvData.reducMat.outerSize(); ++k)
+      for (typename SparseMatrix<Complex>::InnerIterator it(pvData.reducMat,k); it; ++it){
+        int b=dofBlock(k);
+        if (cache.rowBlock(it.row())==-1){
+          cache.rowBlock(it.row())=b;
+          cache.rowLocal(it.row())=blockRowsList[b].size();
+          blockRowsList[b].push_back(it.row());
+        }
+        blockReducTriplets[b].push_back(Triplet<Complex>(cache.rowLocal(it.row()), dofLocal(k), it.value()));
+      }
+    
+    cache.blockDofs.resize(numBlocks);
+    cache.blockRows.resize(numBlocks);
+    cache.blockReducMats.resize(numBlocks);
+    for (int b=0;b<numBlocks;b++){
+      cache.blockDofs[b]=Map<VectorXi>(blockDofsList[b].data(), blockDofsList[b].size());
+      cache.blockRows[b]=Map<VectorXi>(blockRowsList[b].data(), blockRowsList[b].size());
+      cache.blockReducMats[b].resize(blockRowsList[b].size(), blockDofsList[b].size());
+      cache.blockReducMats[b].setFromTriplets(blockReducTriplets[b].begin(), blockReducTriplets[b].end());
+      cache.blockSolvers.push_back(std::unique_ptr<BlockSolver>(new BlockSolver()));
+    }
+  }
   
-    pvData.alignRhs.resize(rowCounter);
-    for (int i=0;i<alignRhsList.size();i++)
-      pvData.alignRhs.segment(i*realN,realN)=alignRhsList[i];
+  
+  // Assembles block b of the reduced system (see polyvector_analyze_blocks()) directly from the energy operators restricted to its coefficients, with the current weights.
+  template<typename Scalar>
+  IGL_INLINE void polyvector_block_lhs(const PolyVectorDataT<Scalar>& pvData,
+                                       const int b,
+                                       Eigen::SparseMatrix<std::complex<Scalar>>& blockLhs)
+  {
+    using namespace std;
+    using namespace Eigen;
+    typedef complex<Scalar> Complex;
+    const typename PolyVectorDataT<Scalar>::SolveCache& cache = pvData.cache;
+    const VectorXi& currRows = cache.blockRows[b];
     
-    pvData.alignMat.resize(rowCounter, N*F.rows());
-    pvData.alignMat.setFromTriplets(alignTriplets.begin(), alignTriplets.end());
+    const SparseMatrix<Complex>* lhsMats[3]={&pvData.smoothLhs, &pvData.roSyLhs, &pvData.alignLhs};
+    const Complex weights[3]={Complex(pvData.wSmooth/pvData.totalSmoothWeight), Complex(pvData.wRoSy/pvData.totalRoSyWeight), Complex(1.0/pvData.totalConstrainedWeight)};
+    vector<Triplet<Complex>> blockTriplets;
+    for (int m=0;m<3;m++)
+      for (int j=0;j<currRows.size();j++)
+        for (typename SparseMatrix<Complex>::InnerIterator it(*lhsMats[m],currRows(j)); it; ++it)
+          if (cache.rowBlock(it.row())==b)  //other blocks are not coupled, and fixed coefficients only contribute to the right-hand side
+            blockTriplets.push_back(Triplet<Complex>(cache.rowLocal(it.row()), j, weights[m]*it.value()));
     
-    pvData.WAlign.resize(rowCounter,rowCounter);
-    pvData.WAlign.setFromTriplets(WAlignTriplets.begin(), WAlignTriplets.end());
+    SparseMatrix<Complex> blockUnreducedLhs(currRows.size(), currRows.size());
+    blockUnreducedLhs.setFromTriplets(blockTriplets.begin(), blockTriplets.end());
+    blockLhs = cache.blockReducMats[b].adjoint()*blockUnreducedLhs*cache.blockReducMats[b];
   }
-
-
+  
+  
+  // Splits the first sizeF x sizeF block of a matrix of pvData (the first polynomial coefficient) into the triplets of every connected component, with faces renumbered by faceLocal.
+  // An empty faceLocal keeps the global numbering, and puts everything in the first component.
+  template<typename Scalar>
+  IGL_INLINE void polyvector_component_triplets(const PolyVectorDataT<Scalar>& pvData,
+                                                const Eigen::SparseMatrix<std::complex<Scalar>>& mat,
+                                                const Eigen::VectorXi& faceLocal,
+                                                std::vector<std::vector<Eigen::Triplet<std::complex<Scalar>>>>& componentTriplets)
+  {
+    using namespace Eigen;
+    typedef std::complex<Scalar> Complex;
+    for (int k=0; k<pvData.sizeF; ++k)
+      for (typename SparseMatrix<Complex>::InnerIterator it(mat,k); it; ++it){
+        if (it.row()>=pvData.sizeF)
+          continue;
+        if (faceLocal.size()==0)
+          componentTriplets[0].push_back(Triplet<Complex>(it.row(), it.col(), it.value()));
+        else  //components are never coupled
+          componentTriplets[pvData.faceComponents(it.col())].push_back(Triplet<Complex>(faceLocal(it.row()), faceLocal(it.col()), it.value()));
+      }
+  }
+  
+  
   // Computes a polyvector on the entire mesh
+  // The reduced system and its factorization are kept in pvData: a repeated call only re-solves when nothing changed, or when only soft-alignment targets changed with a single dof per face (power fields, or sign-symmetric N=2).
+  // A change of wSmooth, wRoSy (keeping its sign), or of the alignment weights refactorizes numerically, reusing the symbolic analysis. polyvector_precompute() invalidates everything.
   // Inputs:
-  //  PolyVectorData: The data structure which should have been initialized with polyvector_precompute()
+  //  PolyVectorData: The data structure which should have been initialized with polyvector_precompute() (only its mutable cache is updated)
   // Outputs:
   //  polyVectorField: #F by N The output interpolated field, in polyvector (complex polynomial) format.
-  IGL_INLINE void polyvector_field(const PolyVectorData& pvData,
-                                   Eigen::MatrixXcd& polyVectorField)
+  template<typename Scalar>
+  IGL_INLINE void polyvector_field(const PolyVectorDataT<Scalar>& pvData,
+                                   Eigen::Matrix<std::complex<Scalar>, Eigen::Dynamic, Eigen::Dynamic>& polyVectorField)
   {
     using namespace std;
     using namespace Eigen;
+    typedef complex<Scalar> Complex;
+    typedef typename PolyVectorDataT<Scalar>::VectorXc VectorXc;
+    typedef typename PolyVectorDataT<Scalar>::MatrixXc MatrixXc;
     
-    //forming total energy matrix;
-    SparseMatrix<complex<double>> totalUnreducedLhs = pvData.wSmooth * (pvData.smoothMat.adjoint()*pvData.WSmooth*pvData.smoothMat)/pvData.totalSmoothWeight + (pvData.wRoSy*pvData.roSyMat.adjoint()*pvData.WRoSy*pvData.roSyMat)/pvData.totalRoSyWeight + (pvData.alignMat.adjoint()*pvData.WAlign*pvData.alignMat)/pvData.totalConstrainedWeight;
-    VectorXcd totalUnreducedRhs= (pvData.alignMat.adjoint()*pvData.WAlign*pvData.alignRhs)/pvData.totalConstrainedWeight;
-        
-    SparseMatrix<complex<double>> totalLhs = pvData.reducMat.adjoint()*totalUnreducedLhs*pvData.reducMat;
-    VectorXcd totalRhs = pvData.reducMat.adjoint()*(totalUnreducedRhs - totalUnreducedLhs*pvData.reducRhs);
-    polyVectorField=MatrixXcd::Zero(pvData.sizeF, pvData.N);
+    polyVectorField=MatrixXc::Zero(pvData.sizeF, pvData.N);
     if (pvData.constFaces.size() == 0)  //alignmat should be empty and the reduction matrix should be only sign symmetry, if applicable
     {
-     //using a matrix with only the first sizeF x sizeF block
-      vector<Triplet<complex<double>>> X0LhsTriplets, X0MTriplets;
-      SparseMatrix<complex<double>> X0Lhs, X0M;
-      for (int k=0; k<totalUnreducedLhs.outerSize(); ++k)
-        for (SparseMatrix<std::complex<double>>::InnerIterator it(totalUnreducedLhs,k); it; ++it)
-          if ((it.row()<pvData.sizeF)&&(it.col()<pvData.sizeF))
-            X0LhsTriplets.push_back(Triplet<complex<double>>(it.row(), it.col(), it.value()*pvData.totalSmoothWeight));  //to bypass the early convergence of igl eigenvalues...
-      
-      X0Lhs.resize(pvData.sizeF, pvData.sizeF);
-      X0Lhs.setFromTriplets(X0LhsTriplets.begin(), X0LhsTriplets.end());
-      
-      for (int k=0; k<pvData.M.outerSize(); ++k)
-        for (SparseMatrix<std::complex<double>>::InnerIterator it(pvData.M,k); it; ++it)
-          if ((it.row()<pvData.sizeF)&&(it.col()<pvData.sizeF))
-            X0MTriplets.push_back(Triplet<complex<double>>(it.row(), it.col(), it.value()*pvData.totalSmoothWeight));
-      
-      X0M.resize(pvData.sizeF, pvData.sizeF);
-      X0M.setFromTriplets(X0MTriplets.begin(), X0MTriplets.end());
+      //using a matrix with only the first sizeF x sizeF block (the RoSy energy vanishes there, and the eigenvectors do not depend on wSmooth)
+      if (pvData.numComponents<2){
+        if (!pvData.eigData.factorized){
+          vector<vector<Triplet<Complex>>> X0LhsTriplets(1), X0MTriplets(1);
+          polyvector_component_triplets(pvData, pvData.smoothLhs, VectorXi(), X0LhsTriplets);
+          polyvector_component_triplets(pvData, pvData.M, VectorXi(), X0MTriplets);
           
-      //Extracting first eigenvector
-      Eigen::MatrixXcd U;
-      Eigen::VectorXcd S;
-      complex_eigs(X0Lhs, X0M, 10, U, S);
-      int smallestIndex; S.cwiseAbs().minCoeff(&smallestIndex);
-      
-      polyVectorField.col(0) = U.col(smallestIndex);
+          SparseMatrix<Complex> X0Lhs(pvData.sizeF, pvData.sizeF), X0M(pvData.sizeF, pvData.sizeF);
+          X0Lhs.setFromTriplets(X0LhsTriplets[0].begin(), X0LhsTriplets[0].end());
+          X0M.setFromTriplets(X0MTriplets[0].begin(), X0MTriplets[0].end());
+          
+          smallest_eigenvector_precompute(X0Lhs, X0M, pvData.eigData);
+          assert(pvData.eigData.factorized);
+        }
+        
+        //Extracting first eigenvector
+        VectorXc u;
+        double s;
+        bool converged = smallest_eigenvector(pvData.eigData, u, s);
+        if (!converged)
+          cout<<"polyvector_field(): smallest eigenvector did not converge to the requested tolerance"<<endl;
+        
+        polyVectorField.col(0) = u;
+      } else {
+        //the smallest eigenvalue is (nearly) degenerate across components, so every component gets its own eigenvector
+        VectorXi faceLocal(pvData.sizeF);
+        if (pvData.cache.componentEigData.empty()){
+          vector<vector<int>> componentFacesList(pvData.numComponents);
+          for (int i=0;i<pvData.sizeF;i++){
+            faceLocal(i)=componentFacesList[pvData.faceComponents(i)].size();
+            componentFacesList[pvData.faceComponents(i)].push_back(i);
+          }
+          pvData.cache.componentFaces.resize(pvData.numComponents);
+          for (int c=0;c<pvData.numComponents;c++)
+            pvData.cache.componentFaces[c]=Map<VectorXi>(componentFacesList[c].data(), componentFacesList[c].size());
+          
+          vector<vector<Triplet<Complex>>> X0LhsTriplets(pvData.numComponents), X0MTriplets(pvData.numComponents);
+          polyvector_component_triplets(pvData, pvData.smoothLhs, faceLocal, X0LhsTriplets);
+          polyvector_component_triplets(pvData, pvData.M, faceLocal, X0MTriplets);
+          
+          pvData.cache.componentEigData.resize(pvData.numComponents);
+          igl::parallel_for(pvData.numComponents, [&](const int c){
+            int componentSize=pvData.cache.componentFaces[c].size();
+            SparseMatrix<Complex> X0Lhs(componentSize, componentSize), X0M(componentSize, componentSize);
+            X0Lhs.setFromTriplets(X0LhsTriplets[c].begin(), X0LhsTriplets[c].end());
+            X0M.setFromTriplets(X0MTriplets[c].begin(), X0MTriplets[c].end());
+            pvData.cache.componentEigData[c].reset(new SmallestEigDataT<Scalar>());
+            pvData.cache.componentEigData[c]->tolerance=pvData.eigData.tolerance;
+            pvData.cache.componentEigData[c]->subspaceSize=pvData.eigData.subspaceSize;
+            pvData.cache.componentEigData[c]->maxIterations=pvData.eigData.maxIterations;
+            smallest_eigenvector_precompute(X0Lhs, X0M, *pvData.cache.componentEigData[c]);
+            assert(pvData.cache.componentEigData[c]->factorized);
+          }, 1);
+        }
+        
+        vector<char> converged(pvData.numComponents);
+        igl::parallel_for(pvData.numComponents, [&](const int c){
+          VectorXc u;
+          double s;
+          converged[c] = smallest_eigenvector(*pvData.cache.componentEigData[c], u, s);
+          for (int i=0;i<pvData.cache.componentFaces[c].size();i++)
+            polyVectorField(pvData.cache.componentFaces[c](i),0)=u(i);
+        }, 1);
+        if (find(converged.begin(), converged.end(), 0)!=converged.end())
+          cout<<"polyvector_field(): smallest eigenvector did not converge to the requested tolerance"<<endl;
+      }
     } else { //just solving the system
-      SimplicialLDLT<SparseMatrix<complex<double>>> solver;
-      //solver.analyzePattern(totalLhs);   // for this step the numerical values of A are not used
-      solver.compute(totalLhs);
-      VectorXcd reducedDofs = solver.solve(totalRhs);
-      assert(solver.info() == Success);
-      VectorXcd fullDofs = pvData.reducMat*reducedDofs+pvData.reducRhs;
+      if ((!pvData.cache.lhsFactorized)||(pvData.wSmooth!=pvData.cache.factorWSmooth)||(pvData.wRoSy!=pvData.cache.factorWRoSy)){
+        //the contribution of the fixed dofs, with the total energy applied term by term
+        const Complex wSmooth(pvData.wSmooth/pvData.totalSmoothWeight), wRoSy(pvData.wRoSy/pvData.totalRoSyWeight), wAlign(1.0/pvData.totalConstrainedWeight);
+        VectorXc fixedUnreducedRhs = wSmooth*(pvData.smoothLhs*pvData.reducRhs) + wRoSy*(pvData.roSyLhs*pvData.reducRhs) + wAlign*(pvData.alignLhs*pvData.reducRhs);
+        pvData.cache.fixedRhs = pvData.reducMat.adjoint()*fixedUnreducedRhs;
+        
+        bool analyze = !pvData.cache.patternAnalyzed;
+        if (analyze){
+          polyvector_analyze_blocks(pvData);
+          pvData.cache.patternAnalyzed=true;
+        }
+        
+        if (pvData.cache.blockDofs.empty()){
+          //forming total energy matrix;
+          SparseMatrix<Complex> totalUnreducedLhs = wSmooth * pvData.smoothLhs + wRoSy * pvData.roSyLhs + wAlign * pvData.alignLhs;
+          SparseMatrix<Complex> totalLhs = pvData.reducMat.adjoint()*totalUnreducedLhs*pvData.reducMat;
+          if (analyze)
+            pvData.cache.solver.analyzePattern(totalLhs);   // for this step the numerical values of A are not used
+          pvData.cache.solver.factorize(totalLhs);
+          assert(pvData.cache.solver.info() == Success);
+        } else {
+          int numBlocks=pvData.cache.blockDofs.size();
+          vector<SparseMatrix<Complex>> blockPatterns;
+          if (analyze){
+            //the fill-reducing orderings, where blocks with the same pattern as a previous one reuse its ordering
+            blockPatterns.resize(numBlocks);
+            igl::parallel_for(numBlocks, [&](const int b){
+              polyvector_block_lhs(pvData, b, blockPatterns[b]);
+            }, 1);
+            pvData.cache.blockPerms.resize(numBlocks);
+            for (int b=0;b<numBlocks;b++){
+              int sameAs=-1;
+              for (int c=0;c<b;c++)
+                if ((blockPatterns[c].rows()==blockPatterns[b].rows())&&(blockPatterns[c].nonZeros()==blockPatterns[b].nonZeros())&&
+                    equal(blockPatterns[c].outerIndexPtr(), blockPatterns[c].outerIndexPtr()+blockPatterns[c].outerSize()+1, blockPatterns[b].outerIndexPtr())&&
+                    equal(blockPatterns[c].innerIndexPtr(), blockPatterns[c].innerIndexPtr()+blockPatterns[c].nonZeros(), blockPatterns[b].innerIndexPtr())){
+                  sameAs=c;
+                  break;
+                }
+              
+              if (sameAs!=-1)
+                pvData.cache.blockPerms[b]=pvData.cache.blockPerms[sameAs];
+              else {
+                PermutationMatrix<Dynamic,Dynamic,int> invPerm;
+                AMDOrdering<int> ordering;
+                ordering(blockPatterns[b], invPerm);
+                pvData.cache.blockPerms[b]=invPerm.inverse();
+              }
+            }
+          }
+          
+          igl::parallel_for(numBlocks, [&](const int b){
+            SparseMatrix<Complex> blockLhs, permutedBlock;
+            if (analyze)
+              blockLhs.swap(blockPatterns[b]);
+            else
+              polyvector_block_lhs(pvData, b, blockLhs);
+            permutedBlock = blockLhs.template selfadjointView<Lower>().twistedBy(pvData.cache.blockPerms[b]);
+            if (analyze)
+              pvData.cache.blockSolvers[b]->analyzePattern(permutedBlock);
+            pvData.cache.blockSolvers[b]->factorize(permutedBlock);
+            assert(pvData.cache.blockSolvers[b]->info() == Success);
+          }, 1);
+        }
+        pvData.cache.lhsFactorized=true;
+        pvData.cache.factorWSmooth=pvData.wSmooth;
+        pvData.cache.factorWRoSy=pvData.wRoSy;
+        pvData.cache.rhsAssembled=false;
+      }
+      
+      if (!pvData.cache.rhsAssembled){
+        VectorXc totalUnreducedRhs= (pvData.alignMat.adjoint()*(pvData.WAlign*pvData.alignRhs))/Complex(pvData.totalConstrainedWeight);
+        pvData.cache.totalRhs = pvData.reducMat.adjoint()*totalUnreducedRhs - pvData.cache.fixedRhs;
+        pvData.cache.rhsAssembled=true;
+      }
+      
+      VectorXc reducedDofs;
+      if (pvData.cache.blockDofs.empty()){
+        reducedDofs = pvData.cache.solver.solve(pvData.cache.totalRhs);
+        assert(pvData.cache.solver.info() == Success);
+      } else {
+        reducedDofs.resize(pvData.cache.totalRhs.size());
+        igl::parallel_for(pvData.cache.blockDofs.size(), [&](const int b){
+          const VectorXi& currDofs = pvData.cache.blockDofs[b];
+          VectorXc blockRhs(currDofs.size());
+          for (int j=0;j<currDofs.size();j++)
+            blockRhs(j)=pvData.cache.totalRhs(currDofs(j));
+          VectorXc blockSolution = pvData.cache.blockPerms[b].inverse()*pvData.cache.blockSolvers[b]->solve(pvData.cache.blockPerms[b]*blockRhs);
+          for (int j=0;j<currDofs.size();j++)
+            reducedDofs(currDofs(j))=blockSolution(j);
+        }, 1);
+      }
+      VectorXc fullDofs = pvData.reducMat*reducedDofs+pvData.reducRhs;
       for (int i=0;i<pvData.N;i++)
         polyVectorField.col(i) = fullDofs.segment(i*pvData.sizeF,pvData.sizeF);
       
@@ -374,6 +783,8 @@ namespace directional
 
   
   // minimal version without auxiliary data
+  // The precision of the computation follows polyVectorField (Eigen::MatrixXcd, or Eigen::MatrixXcf for single precision).
+  template<typename Scalar>
   IGL_INLINE void polyvector_field(const Eigen::MatrixXd& V,
                                    const Eigen::MatrixXi& F,
                                    const Eigen::VectorXi& constFaces,
@@ -382,12 +793,12 @@ namespace directional
                                    const double roSyWeight,
                                    const Eigen::VectorXd& alignWeights,
                                    const int N,
-                                   Eigen::MatrixXcd& polyVectorField)
+                                   Eigen::Matrix<std::complex<Scalar>, Eigen::Dynamic, Eigen::Dynamic>& polyVectorField)
   {
     Eigen::MatrixXi EV, xi, EF;
     Eigen::MatrixXd B1, B2, xd;
     igl::local_basis(V, F, B1, B2, xd);
-    PolyVectorData pvData;
+    PolyVectorDataT<Scalar> pvData;
     pvData.constFaces=constFaces;
     pvData.constVectors=constVectors;
     pvData.wAlignment = alignWeights;
@@ -398,17 +809,18 @@ namespace directional
     polyvector_field(pvData, polyVectorField);
   }
 
+template<typename Scalar>
 IGL_INLINE void polyvector_field(const Eigen::MatrixXd& V,
                                  const Eigen::MatrixXi& F,
                                  const Eigen::VectorXi& constFaces,
                                  const Eigen::MatrixXd& constVectors,
                                  const int N,
-                                 Eigen::MatrixXcd& polyVectorField)
+                                 Eigen::Matrix<std::complex<Scalar>, Eigen::Dynamic, Eigen::Dynamic>& polyVectorField)
 {
   Eigen::MatrixXi EV, xi, EF;
   Eigen::MatrixXd B1, B2, xd;
   igl::local_basis(V, F, B1, B2, xd);
-  PolyVectorData pvData;
+  PolyVectorDataT<Scalar> pvData;
   pvData.constFaces=constFaces;
   pvData.constVectors=constVectors;
   pvData.wAlignment = Eigen::VectorXd::Constant(constFaces.size(),-1.0);
@@ -418,6 +830,27 @@ IGL_INLINE void polyvector_field(const Eigen::MatrixXd& V,
   polyvector_precompute(V,F,EV,EF, B1,B2, N, pvData);
   polyvector_field(pvData, polyVectorField);
 }
+
+  // Version with a precomputed mesh topology (see directional::MeshTopology)
+  template<typename Scalar>
+  IGL_INLINE void polyvector_field(const MeshTopology& mesh,
+                                   const Eigen::VectorXi& constFaces,
+                                   const Eigen::MatrixXd& constVectors,
+                                   const double smoothWeight,
+                                   const double roSyWeight,
+                                   const Eigen::VectorXd& alignWeights,
+                                   const int N,
+                                   Eigen::Matrix<std::complex<Scalar>, Eigen::Dynamic, Eigen::Dynamic>& polyVectorField)
+  {
+    PolyVectorDataT<Scalar> pvData;
+    pvData.constFaces=constFaces;
+    pvData.constVectors=constVectors;
+    pvData.wAlignment = alignWeights;
+    pvData.wSmooth = smoothWeight;
+    pvData.wRoSy = roSyWeight;
+    polyvector_precompute(mesh, N, pvData);
+    polyvector_field(pvData, polyVectorField);
+  }
 }
 
 #endif
@@ -16,6 +16,10 @@
 #include <Eigen/Sparse>
 #include <Eigen/SparseCholesky>
 #include <Eigen/Eigenvalues>
+#include <igl/parallel_for.h>
+#include <vector>
+#include <algorithm>
+#include <directional/TangentField.h>
 
 
 
@@ -89,86 +93,235 @@ namespace directional
     polyValues.array()+=z.array();  //the biggest and unit power
   }
   
-  // Converts a field in PolyVector representation to raw represenation.
+  // Closed-form roots of a monic polynomial of degree at most 4 (quadratic formula, Cardano, and Ferrari with the resolvent cubic).
   // Inputs:
-  //  B1, B2:           #F by 3 matrices representing the local base of each face.
-  //  polyVectorField:  #F by N complex PolyVectors
-  //  N:                The degree of the field.
+  //  coeffs: 1 by n (n<=4) coefficients, lowest degree first, of z^n+coeffs(n-1)*z^(n-1)+...+coeffs(0)
   // Outputs:
-  //  raw:              #F by 3*N matrix with all N explicit vectors of each directional in raw format xyzxyz
-  //    returns true if succeeded
-  IGL_INLINE bool polyvector_to_raw(const Eigen::MatrixXd& B1,
-                                    const Eigen::MatrixXd& B2,
-                                    const Eigen::MatrixXcd& pvField,
-                                    const int N,
-                                    Eigen::MatrixXd& rawField,
-                                    bool signSymmetry=true,
-                                    const double rootTolerance=1e-8)
+  //  roots:  1 by n roots (not polished, see polynomial_roots())
+  IGL_INLINE void polynomial_roots_closed_form(const Eigen::RowVectorXcd& coeffs,
+                                               Eigen::RowVectorXcd& roots)
+  {
+    using namespace std;
+    typedef complex<double> Complex;
+    int n=coeffs.size();
+    assert(n>=1 && n<=4);
+    roots.resize(n);
+    
+    //both roots of z^2+b*z+c, avoiding cancellation
+    auto quadratic_roots=[](const Complex& b, const Complex& c, Complex& z1, Complex& z2){
+      Complex d=sqrt(b*b-4.0*c);
+      if ((conj(b)*d).real()<0.0) d=-d;
+      Complex q=-(b+d)/2.0;
+      z1=q;
+      z2=(q==Complex(0.0,0.0) ? Complex(0.0,0.0) : c/q);
+    };
+    
+    //all roots of z^3+a*z^2+b*z+c
+    auto cubic_roots=[](const Complex& a, const Complex& b, const Complex& c, Complex* z){
+      Complex p=b-a*a/3.0;
+      Complex q=2.0*a*a*a/27.0-a*b/3.0+c;
+      Complex sqrtDisc=sqrt(q*q/4.0+p*p*p/27.0);
+      Complex u3=-q/2.0+sqrtDisc;
+      if (abs(-q/2.0-sqrtDisc)>abs(u3)) u3=-q/2.0-sqrtDisc;
+      Complex u=pow(u3,1.0/3.0);
+      Complex v=(u==Complex(0.0,0.0) ? Complex(0.0,0.0) : -p/(3.0*u));
+      Complex omega=exp(Complex(0.0,2.0*igl::PI/3.0));
+      for (int k=0;k<3;k++){
+        z[k]=u+v-a/3.0;
+        u*=omega;
+        v*=conj(omega);
+      }
+    };
+    
+    if (n==1){
+      roots(0)=-coeffs(0);
+    } else if (n==2){
+      quadratic_roots(coeffs(1), coeffs(0), roots(0), roots(1));
+    } else if (n==3){
+      Complex z[3];
+      cubic_roots(coeffs(2), coeffs(1), coeffs(0), z);
+      roots<<z[0], z[1], z[2];
+    } else {
+      //depressing z=y-a/4 into y^4+p*y^2+q*y+r
+      Complex a=coeffs(3), b=coeffs(2), c=coeffs(1), d=coeffs(0);
+      Complex p=b-3.0*a*a/8.0;
+      Complex q=c-a*b/2.0+a*a*a/8.0;
+      Complex r=d-a*c/4.0+a*a*b/16.0-3.0*a*a*a*a/256.0;
+      Complex y[4];
+      if (abs(q)<=1e-14*(abs(p)*abs(p)+abs(r)+1e-300)){  //biquadratic
+        Complex y2[2];
+        quadratic_roots(p, r, y2[0], y2[1]);
+        y[0]=sqrt(y2[0]); y[1]=-y[0];
+        y[2]=sqrt(y2[1]); y[3]=-y[2];
+      } else {
+        //resolvent cubic 8m^3+8pm^2+(2p^2-8r)m-q^2=0; any nonzero root works, the largest is the most stable
+        Complex m[3];
+        cubic_roots(p, (p*p-4.0*r)/4.0, -q*q/8.0, m);
+        Complex bestM=m[0];
+        for (int k=1;k<3;k++)
+          if (abs(m[k])>abs(bestM)) bestM=m[k];
+        Complex s=sqrt(2.0*bestM);
+        for (int sign=-1;sign<=1;sign+=2){
+          Complex t=sqrt(-(2.0*p+2.0*bestM+(double)sign*2.0*q/s));
+          y[sign+1]=((double)sign*s+t)/2.0;
+          y[sign+2]=((double)sign*s-t)/2.0;
+        }
+      }
+      for (int k=0;k<4;k++)
+        roots(k)=y[k]-a/4.0;
+    }
+  }
+  
+  
+  // Roots of a monic polynomial by Weierstrass (Durand-Kerner) iterations, where each root is updated with the latest values of the others.
+  // For degree at most 4, the iterations start from the closed-form roots and usually stop immediately.
+  // Inputs:
+  //  coeffs:         1 by n coefficients, lowest degree first, of z^n+coeffs(n-1)*z^(n-1)+...+coeffs(0)
+  //  rootTolerance:  the required |p(root)| of all roots
+  //  maxIterations:  maximum number of single-root updates
+  // Outputs:
+  //  roots:          1 by n roots
+  //  returns true if all roots reached rootTolerance
+  IGL_INLINE bool polynomial_roots(const Eigen::RowVectorXcd& coeffs,
+                                   Eigen::RowVectorXcd& roots,
+                                   const double rootTolerance=1e-8,
+                                   const int maxIterations=1000)
   {
     using namespace std;
     using namespace Eigen;
-    rawField.resize(B1.rows(), 3 * N);
-    if (N%2!=0) signSymmetry=false;  //by definition
-    MatrixXcd actualPVField;
-    int actualN;
-    if (signSymmetry){
-      actualPVField.resize(pvField.rows(),N/2);
-      for (int i=0;i<N;i+=2)
-        actualPVField.col(i/2)=pvField.col(i);
-      actualN=N/2;
-    } else{
-      actualPVField=pvField;
-      actualN=N;
+    int n=coeffs.size();
+    if (n<=4)
+      polynomial_roots_closed_form(coeffs, roots);
+    else {
+      roots.resize(n);
+      roots(0)=pow(-coeffs(0),1.0/(double)n);
+      for (int i=1;i<n;i++)
+        roots(i)=roots(i-1)*std::exp(std::complex<double>(0,2.0*igl::PI/(double)n));
     }
     
-    MatrixXcd roots(actualPVField.rows(),actualN);
-    roots.col(0).array()=(-actualPVField.col(0).array()).pow(1.0/(double)actualN);
-    for (int i=1;i<actualN;i++)
-      roots.col(i).array()=roots.col(i-1).array()*std::exp(std::complex<double>(0,2.0*igl::PI/(double)actualN));
+    auto eval=[&](const std::complex<double>& z){
+      std::complex<double> value=1.0;
+      for (int i=n-1;i>=0;i--)
+        value=value*z+coeffs(i);
+      return value;
+    };
+    
+    VectorXd rootError(n);
+    for (int i=0;i<n;i++)
+      rootError(i)=abs(eval(roots(i)));
     
-    MatrixXd rootError=MatrixXd::Constant(actualPVField.rows(),actualN, 1000.0);
-    double maxError=1000.0;
     int currRoot=0;
-    MatrixXcd mostRoots(actualPVField.rows(),actualN-1);
-    int maxIterations=1000;
     int currIteration=0;
-    do{
-      mostRoots.block(0,0, mostRoots.rows(),currRoot)=roots.block(0,0, roots.rows(),currRoot);
-      mostRoots.block(0,currRoot, mostRoots.rows(),actualN-currRoot-1)=roots.block(0,currRoot+1, roots.rows(),actualN-currRoot-1);
-      VectorXcd numerator; polynomial_eval(actualPVField, roots.col(currRoot), numerator);
-      VectorXcd denominator; polynomial_eval_from_roots(mostRoots, roots.col(currRoot), denominator);
-      roots.col(currRoot).array()-=numerator.array()/denominator.array();
-      rootError.col(currRoot)=numerator.cwiseAbs();
-      maxError=rootError.lpNorm<Infinity>();  //optimize by only the relevant column?
-      currRoot=(currRoot+1)%actualN;
+    while ((rootError.maxCoeff()>rootTolerance)&&(currIteration<maxIterations)){
+      std::complex<double> numerator=eval(roots(currRoot));
+      std::complex<double> denominator=1.0;
+      for (int j=0;j<n;j++)
+        if (j!=currRoot)
+          denominator*=roots(currRoot)-roots(j);
+      if (denominator!=std::complex<double>(0.0,0.0))
+        roots(currRoot)-=numerator/denominator;
+      rootError(currRoot)=abs(numerator);
+      currRoot=(currRoot+1)%n;
       currIteration++;
-    }while ((maxError>rootTolerance)&&(currIteration<maxIterations));
-    
-    if (currIteration>=maxIterations)
-      return false;
+    }
     
-    if (signSymmetry)
-      roots=roots.cwiseSqrt();
+    return (rootError.maxCoeff()<=rootTolerance);
+  }
   
-    for (int f=0;f<roots.rows();f++){
-      RowVectorXcd rowRoots=roots.row(f);
-      std::sort(rowRoots.data(), rowRoots.data() + rowRoots.size(), [](std::complex<double> a, std::complex<double> b){return arg(a) < arg(b);});
-      roots.row(f)=rowRoots;
-    }
+  
+  // Converts a field in PolyVector representation to tangent representation (the roots themselves, see directional::TangentField).
+  // The roots of every face are found independently (see polynomial_roots()) and in parallel, so that each face stops iterating as soon as it converges.
+  // Inputs:
+  //  polyVectorField:  #F by N complex PolyVectors
+  //  N:                The degree of the field.
+  // Outputs:
+  //  tangentField:     #F by N roots of each face, sorted CCW
+  //  failedFaces:      the faces whose roots did not reach rootTolerance (their roots are the last iterates)
+  //    returns true if all faces succeeded
+  // The roots are always found in double precision; a single-precision field is only rounded when stored.
+  template<typename Scalar>
+  IGL_INLINE bool polyvector_to_raw(const Eigen::Matrix<std::complex<Scalar>, Eigen::Dynamic, Eigen::Dynamic>& pvField,
+                                    const int N,
+                                    TangentFieldT<Scalar>& tangentField,
+                                    Eigen::VectorXi& failedFaces,
+                                    bool signSymmetry=true,
+                                    const double rootTolerance=1e-8)
+  {
+    using namespace std;
+    using namespace Eigen;
+    if (N%2!=0) signSymmetry=false;  //by definition
+    int actualN = (signSymmetry ? N/2 : N);
+    int jump = (signSymmetry ? 2 : 1);
     
-    if (signSymmetry){
-      MatrixXcd actualRoots(roots.rows(), 2*roots.cols());
-      actualRoots<<roots, -roots;
-      roots=actualRoots;
-    }
-   
-    for (int i = 0; i < N; i++)
-      for (int f=0;f<pvField.rows();f++){
-        std::complex<double> root = roots(f,i);
-        rawField.block<1, 3>(f, 3 * i) = B1.row(f) * root.real() + B2.row(f) * root.imag();
-      }
+    tangentField.field.resize(pvField.rows(), N);
+    VectorXi faceConverged(pvField.rows());
+    igl::parallel_for(pvField.rows(), [&](const int f){
+      RowVectorXcd coeffs(actualN), roots;
+      for (int i=0;i<N;i+=jump)
+        coeffs(i/jump)=std::complex<double>(pvField(f,i));
       
-    return true;
+      faceConverged(f)=(polynomial_roots(coeffs, roots, rootTolerance) ? 1 : 0);
+      
+      if (signSymmetry)
+        roots=roots.cwiseSqrt();
+      
+      std::sort(roots.data(), roots.data() + roots.size(), [](std::complex<double> a, std::complex<double> b){return arg(a) < arg(b);});
+      
+      for (int i=0;i<actualN;i++){
+        tangentField.field(f,i) = std::complex<Scalar>(roots(i));
+        if (signSymmetry)
+          tangentField.field(f,i+actualN) = -std::complex<Scalar>(roots(i));
+      }
+    }, 1000);
+    
+    vector<int> failedList;
+    for (int f=0;f<faceConverged.size();f++)
+      if (!faceConverged(f))
+        failedList.push_back(f);
+    failedFaces=Map<VectorXi>(failedList.data(), failedList.size());
+    
+    return failedList.empty();
+  }
+  
+  
+  // Converts a field in PolyVector representation to raw represenation.
+  // Inputs:
+  //  B1, B2:           #F by 3 matrices representing the local base of each face.
+  //  polyVectorField:  #F by N complex PolyVectors
+  //  N:                The degree of the field.
+  // Outputs:
+  //  raw:              #F by 3*N matrix with all N explicit vectors of each directional in raw format xyzxyz
+  //  failedFaces:      the faces whose roots did not reach rootTolerance (their vectors are the last iterates)
+  //    returns true if all faces succeeded
+  template<typename Scalar>
+  IGL_INLINE bool polyvector_to_raw(const Eigen::MatrixXd& B1,
+                                    const Eigen::MatrixXd& B2,
+                                    const Eigen::Matrix<std::complex<Scalar>, Eigen::Dynamic, Eigen::Dynamic>& pvField,
+                                    const int N,
+                                    Eigen::MatrixXd& rawField,
+                                    Eigen::VectorXi& failedFaces,
+                                    bool signSymmetry=true,
+                                    const double rootTolerance=1e-8)
+  {
+    TangentFieldT<Scalar> tangentField;
+    bool success = polyvector_to_raw(pvField, N, tangentField, failedFaces, signSymmetry, rootTolerance);
+    tangentField.get_raw(B1, B2, rawField);
+    return success;
+  }
+  
+  
+  // Version that only reports whether all faces succeeded.
+  template<typename Scalar>
+  IGL_INLINE bool polyvector_to_raw(const Eigen::MatrixXd& B1,
+                                    const Eigen::MatrixXd& B2,
+                                    const Eigen::Matrix<std::complex<Scalar>, Eigen::Dynamic, Eigen::Dynamic>& pvField,
+                                    const int N,
+                                    Eigen::MatrixXd& rawField,
+                                    bool signSymmetry=true,
+                                    const double rootTolerance=1e-8)
+  {
+    Eigen::VectorXi failedFaces;
+    return polyvector_to_raw(B1, B2, pvField, N, rawField, failedFaces, signSymmetry, rootTolerance);
   }
   
   }
@@ -31,22 +31,31 @@ namespace directional
   //  alignWeights: #constFaces x 1 soft weights for alignment (negative values = fixed faces).
   //  N: The degree of the field.
   // Outputs:
-  //  powerField: #F by 2 The output interpolated field, in complex numbers.
+  //  powerField: #F by 2 The output interpolated field, in complex numbers (Eigen::MatrixXcd, or Eigen::MatrixXcf to compute in single precision).
+  template<typename Scalar>
   IGL_INLINE void power_field(const Eigen::MatrixXd& V,
                               const Eigen::MatrixXi& F,
                               const Eigen::VectorXi& constFaces,
                               const Eigen::MatrixXd& constVectors,
                               const Eigen::VectorXd& alignWeights,
                               const int N,
-                              Eigen::MatrixXcd& powerField)
+                              Eigen::Matrix<std::complex<Scalar>, Eigen::Dynamic, Eigen::Dynamic>& powerField)
   {
-    Eigen::MatrixXi EV, xi, EF;
-    igl::edge_topology(V, F, EV, xi, EF);
-    Eigen::MatrixXd B1, B2, xd;
-    igl::local_basis(V, F, B1, B2, xd);
-    
     polyvector_field(V,F,constFaces,constVectors,1.0, -1.0, alignWeights, N, powerField);
-    powerField=-powerField.col(0);  //powerfield is represented positively
+    powerField=(-powerField.col(0)).eval();  //powerfield is represented positively (evaluated first, as the assignment shrinks powerField)
+  }
+  
+  // Version with a precomputed mesh topology (see directional::MeshTopology)
+  template<typename Scalar>
+  IGL_INLINE void power_field(const MeshTopology& mesh,
+                              const Eigen::VectorXi& constFaces,
+                              const Eigen::MatrixXd& constVectors,
+                              const Eigen::VectorXd& alignWeights,
+                              const int N,
+                              Eigen::Matrix<std::complex<Scalar>, Eigen::Dynamic, Eigen::Dynamic>& powerField)
+  {
+    polyvector_field(mesh,constFaces,constVectors,1.0, -1.0, alignWeights, N, powerField);
+    powerField=(-powerField.col(0)).eval();  //powerfield is represented positively (evaluated first, as the assignment shrinks powerField)
   }
 }
 
@@ -34,13 +34,8 @@ namespace directional
     representativeField.conservativeResize(B1.rows(), 3);
     for (int f = 0; f < B1.rows(); ++f)
     {
-      // Find the roots of p(t) = (t - c0)^n using
-      // https://en.wikipedia.org/wiki/Companion_matrix
-      Eigen::MatrixXcd M = Eigen::MatrixXcd::Zero(N, N);
-      for (int i = 1; i < N; ++i)
-        M(i, i - 1) = std::complex<double>(1, 0);
-      M(0, N - 1) = powerField(f, 0);
-      std::complex<double> root = M.eigenvalues()(0);
+      // Any root of t^N = c0 is a representative; the principal one is in closed form
+      std::complex<double> root = std::pow(powerField(f, 0), 1.0/(double)N);
       representativeField.row(f) = B1.row(f) * root.real() + B2.row(f) * root.imag();
     }
   }
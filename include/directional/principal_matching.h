@@ -16,109 +16,204 @@
 #include <igl/edge_topology.h>
 #include <directional/representative_to_raw.h>
 #include <directional/effort_to_indices.h>
+#include <directional/MeshTopology.h>
+#include <directional/edge_transport.h>
+#include <directional/TangentField.h>
+#include <igl/parallel_for.h>
 
 namespace directional
 {
-  // Takes a field in raw form and computes both the principal effort and the consequent principal matching on every edge.
-  // Important: if the Raw field in not CCW ordered, the result is meaningless.
-  // Input:
-  //  V:      #V x 3 vertex coordinates
-  //  F:      #F x 3 face vertex indices
-  //  EV:     #E x 2 edges to vertices indices
-  //  EF:     #E x 2 edges to faces indices
-  //  raw:    The directional field, assumed to be ordered CCW, and in xyzxyzxyz...xyz (3*N cols) form. The degree is inferred by the size.
-  // Output:
-  //  matching: #E matching function, where vector k in EF(i,0) matches to vector (k+matching(k))%N in EF(i,1). In case of boundary, there is a -1.
-  //  effort: #E principal matching efforts.
-  //  singVertices: indices (into V) of which vertices are singular; including boundary vertices which carry the singularity of their loop
-  //  singIndices: the index of the singular vertices (corresponding with singIndices), relative to N (the true index is then i/N). This discludes boundary vertices (boundary cycles have their own index along generator cycles)
-  IGL_INLINE void principal_matching(const Eigen::MatrixXd& V,
-                                     const Eigen::MatrixXi& F,
-                                     const Eigen::MatrixXi& EV,
-                                     const Eigen::MatrixXi& EF,
-                                     const Eigen::MatrixXi& FE,
-                                     const Eigen::MatrixXd& rawField,
-                                     Eigen::VectorXi& matching,
-                                     Eigen::VectorXd& effort,
-                                     Eigen::VectorXi& singVertices,
-                                     Eigen::VectorXi& singIndices)
+  // The kernel of principal_matching() for a degree NT that is known at compile time, so that the per-edge loops over the N vectors use fixed-size types.
+  // NT=Eigen::Dynamic is the generic version for any degree N.
+  // The edges are processed in parallel, each writing only its own matching and effort, so the result does not depend on the number of threads.
+  template<int NT>
+  IGL_INLINE void principal_matching_degree(const Eigen::MatrixXi& EF,
+                                            const Eigen::VectorXcd& edgeTransport,
+                                            const Eigen::MatrixXcd& complexField,
+                                            const int N,
+                                            Eigen::VectorXi& matching,
+                                            Eigen::VectorXd& effort)
   {
-    
     typedef std::complex<double> Complex;
+    typedef Eigen::Matrix<Complex, 1, NT> RowVectorNc;
     using namespace Eigen;
     using namespace std;
     
-    MatrixXd B1, B2, B3;
-    igl::local_basis(V, F, B1, B2, B3);
-    
-    int N = rawField.cols() / 3;
+    const int n = (NT==Dynamic ? N : NT);
     
     matching.conservativeResize(EF.rows());
     matching.setConstant(-1);
     
-    VectorXcd edgeTransport(EF.rows());  //the difference in the angle representation of edge i from EF(i,0) to EF(i,1)
-    MatrixXd edgeVectors(EF.rows(), 3);
-    for (int i = 0; i < EF.rows(); i++) {
-      if (EF(i, 0) == -1 || EF(i, 1) == -1)
-        continue;
-      edgeVectors.row(i) = (V.row(EV(i, 1)) - V.row(EV(i, 0))).normalized();
-      Complex ef(edgeVectors.row(i).dot(B1.row(EF(i, 0))), edgeVectors.row(i).dot(B2.row(EF(i, 0))));
-      Complex eg(edgeVectors.row(i).dot(B1.row(EF(i, 1))), edgeVectors.row(i).dot(B2.row(EF(i, 1))));
-      edgeTransport(i) = eg / ef;
-    }
-    
     effort = VectorXd::Zero(EF.rows());
-    for (int i = 0; i < EF.rows(); i++) {
+    igl::parallel_for(EF.rows(), [&](const int i){
       if (EF(i, 0) == -1 || EF(i, 1) == -1)
-        continue;
+        return;
       //computing free coefficient effort (a.k.a. [Diamanti et al. 2014])
-      //Complex freeCoeffEffort(1.0, 0.0);
       double minRotAngle=10000.0;
       int indexMinFromZero=0;
       
       //computing some effort and the extracting principal one
       Complex freeCoeff(1.0,0.0);
       //finding where the 0 vector in EF(i,0) goes to with smallest rotation angle in EF(i,1), computing the effort, and then adjusting the matching to have principal effort.
-      
-      RowVector3d vec0f = rawField.block(EF(i, 0), 0, 1, 3);
-      Complex vec0fc = Complex(vec0f.dot(B1.row(EF(i, 0))), vec0f.dot(B2.row(EF(i, 0))));
-      Complex transvec0fc = vec0fc*edgeTransport(i);
-      for (int j = 0; j < N; j++) {
-        RowVector3d vecjf = rawField.block(EF(i, 0), 3 * j, 1, 3);
-        Complex vecjfc = Complex(vecjf.dot(B1.row(EF(i, 0))), vecjf.dot(B2.row(EF(i, 0))));
-        RowVector3d vecjg = rawField.block(EF(i, 1), 3 * j, 1, 3);
-        Complex vecjgc = Complex(vecjg.dot(B1.row(EF(i, 1))), vecjg.dot(B2.row(EF(i, 1))));
-        Complex transvecjfc = vecjfc*edgeTransport(i);
-        freeCoeff *= (vecjgc / transvecjfc);
-        double currRotAngle =arg(vecjgc / transvec0fc);
+      RowVectorNc transVecsf = complexField.row(EF(i, 0))*edgeTransport(i);
+      RowVectorNc vecsg = complexField.row(EF(i, 1));
+      for (int j = 0; j < n; j++) {
+        freeCoeff *= (vecsg(j) / transVecsf(j));
+        double currRotAngle =arg(vecsg(j) / transVecsf(0));
         if (abs(currRotAngle)<abs(minRotAngle)){
           indexMinFromZero=j;
           minRotAngle=currRotAngle;
         }
-        
-        //taking principal effort
-        
       }
       effort(i) = arg(freeCoeff);
       
       //finding the matching that implements effort(i)
       //This is still not perfect
       double currEffort=0;
-      for (int j = 0; j < N; j++) {
-        RowVector3d vecjf = rawField.block(EF(i, 0), 3*j, 1, 3);
-        Complex vecjfc = Complex(vecjf.dot(B1.row(EF(i, 0))), vecjf.dot(B2.row(EF(i, 0))));
-        RowVector3d vecjg = rawField.block(EF(i, 1), 3 *((j+indexMinFromZero+N)%N), 1, 3);
-        Complex vecjgc = Complex(vecjg.dot(B1.row(EF(i, 1))), vecjg.dot(B2.row(EF(i, 1))));
-        Complex transvecjfc = vecjfc*edgeTransport(i);
-        currEffort+= arg(vecjgc / transvecjfc);
-      }
+      for (int j = 0; j < n; j++)
+        currEffort+= arg(vecsg((j+indexMinFromZero+n)%n) / transVecsf(j));
    
       matching(i)=indexMinFromZero-round((currEffort-effort(i))/(2.0*igl::PI));
+    }, 1000);
+  }
+  
+  
+  // Takes a field in tangent form and computes both the principal effort and the consequent principal matching on every edge, given precomputed edge transport (see directional::edge_transport).
+  // The vectors are read directly in their local bases, without any projection.
+  // Important: if the field in not CCW ordered, the result is meaningless.
+  // Input:
+  //  EF:             #E x 2 edges to faces indices
+  //  edgeTransport:  #E transport from EF(i,0) to EF(i,1)
+  //  tangentField:   The directional field (see directional::TangentField).
+  // Output:
+  //  as below.
+  IGL_INLINE void principal_matching(const Eigen::MatrixXi& EF,
+                                     const Eigen::VectorXcd& edgeTransport,
+                                     const TangentField& tangentField,
+                                     Eigen::VectorXi& matching,
+                                     Eigen::VectorXd& effort)
+  {
+    int N = tangentField.N();
+    const Eigen::MatrixXcd& complexField = tangentField.field;
+    switch (N){
+      case 1: principal_matching_degree<1>(EF, edgeTransport, complexField, N, matching, effort); break;
+      case 2: principal_matching_degree<2>(EF, edgeTransport, complexField, N, matching, effort); break;
+      case 4: principal_matching_degree<4>(EF, edgeTransport, complexField, N, matching, effort); break;
+      case 6: principal_matching_degree<6>(EF, edgeTransport, complexField, N, matching, effort); break;
+      default: principal_matching_degree<Eigen::Dynamic>(EF, edgeTransport, complexField, N, matching, effort);
     }
-          
-    //Getting final singularities and their indices
-    effort_to_indices(V,F,EV, EF, effort,matching,N,singVertices,singIndices);
+  }
+  
+  // Version with a raw field and precomputed edge transport, for repeated matchings on the same mesh.
+  IGL_INLINE void principal_matching(const Eigen::MatrixXi& EF,
+                                     const Eigen::MatrixXd& B1,
+                                     const Eigen::MatrixXd& B2,
+                                     const Eigen::VectorXcd& edgeTransport,
+                                     const Eigen::MatrixXd& rawField,
+                                     Eigen::VectorXi& matching,
+                                     Eigen::VectorXd& effort)
+  {
+    TangentField tangentField(B1, B2, rawField);
+    principal_matching(EF, edgeTransport, tangentField, matching, effort);
+  }
+  
+  // Takes a field in raw form and computes both the principal effort and the consequent principal matching on every edge, given a precomputed local basis.
+  // Important: if the Raw field in not CCW ordered, the result is meaningless.
+  // Input:
+  //  V:      #V x 3 vertex coordinates
+  //  EV:     #E x 2 edges to vertices indices
+  //  EF:     #E x 2 edges to faces indices
+  //  B1, B2: #F x 3 matrices representing the local base of each face.
+  //  raw:    The directional field, assumed to be ordered CCW, and in xyzxyzxyz...xyz (3*N cols) form. The degree is inferred by the size.
+  // Output:
+  //  matching: #E matching function, where vector k in EF(i,0) matches to vector (k+matching(k))%N in EF(i,1). In case of boundary, there is a -1.
+  //  effort: #E principal matching efforts.
+  IGL_INLINE void principal_matching(const Eigen::MatrixXd& V,
+                                     const Eigen::MatrixXi& EV,
+                                     const Eigen::MatrixXi& EF,
+                                     const Eigen::MatrixXd& B1,
+                                     const Eigen::MatrixXd& B2,
+                                     const Eigen::MatrixXd& rawField,
+                                     Eigen::VectorXi& matching,
+                                     Eigen::VectorXd& effort)
+  {
+    Eigen::MatrixXd edgeVectors;
+    Eigen::VectorXcd edgeTransport;
+    edge_transport(V, EV, EF, B1, B2, edgeVectors, edgeTransport);
+    principal_matching(EF, B1, B2, edgeTransport, rawField, matching, effort);
+  }
+  
+  // Takes a field in raw form and computes both the principal effort and the consequent principal matching on every edge.
+  // Important: if the Raw field in not CCW ordered, the result is meaningless.
+  // Input:
+  //  V:      #V x 3 vertex coordinates
+  //  F:      #F x 3 face vertex indices
+  //  EV:     #E x 2 edges to vertices indices
+  //  EF:     #E x 2 edges to faces indices
+  //  raw:    The directional field, assumed to be ordered CCW, and in xyzxyzxyz...xyz (3*N cols) form. The degree is inferred by the size.
+  // Output:
+  //  matching: #E matching function, where vector k in EF(i,0) matches to vector (k+matching(k))%N in EF(i,1). In case of boundary, there is a -1.
+  //  effort: #E principal matching efforts.
+  //  singVertices: indices (into V) of which vertices are singular; including boundary vertices which carry the singularity of their loop
+  //  singIndices: the index of the singular vertices (corresponding with singIndices), relative to N (the true index is then i/N). This discludes boundary vertices (boundary cycles have their own index along generator cycles)
+  IGL_INLINE void principal_matching(const Eigen::MatrixXd& V,
+                                     const Eigen::MatrixXi& F,
+                                     const Eigen::MatrixXi& EV,
+                                     const Eigen::MatrixXi& EF,
+                                     const Eigen::MatrixXi& FE,
+                                     const Eigen::MatrixXd& rawField,
+                                     Eigen::VectorXi& matching,
+                                     Eigen::VectorXd& effort,
+                                     Eigen::VectorXi& singVertices,
+                                     Eigen::VectorXi& singIndices)
+  {
+    Eigen::MatrixXd B1, B2, B3;
+    igl::local_basis(V, F, B1, B2, B3);
+    principal_matching(V, EV, EF, B1, B2, rawField, matching, effort);
     
+    //Getting final singularities and their indices
+    effort_to_indices(V,F,EV, EF, effort,matching,rawField.cols()/3,singVertices,singIndices);
+  }
+  
+  //Version with precomputed local bases (as in igl::local_basis) and singularity detector (see directional::SingularityDetector), for repeated matchings on the same mesh.
+  IGL_INLINE void principal_matching(const Eigen::MatrixXd& V,
+                                     const Eigen::MatrixXi& EV,
+                                     const Eigen::MatrixXi& EF,
+                                     const Eigen::MatrixXd& B1,
+                                     const Eigen::MatrixXd& B2,
+                                     const SingularityDetector& sd,
+                                     const Eigen::MatrixXd& rawField,
+                                     Eigen::VectorXi& matching,
+                                     Eigen::VectorXd& effort,
+                                     Eigen::VectorXi& singVertices,
+                                     Eigen::VectorXi& singIndices)
+  {
+    principal_matching(V, EV, EF, B1, B2, rawField, matching, effort);
+    effort_to_indices(sd, effort, matching, rawField.cols()/3, singVertices, singIndices);
+  }
+  
+  //Version with a precomputed mesh topology (see directional::MeshTopology)
+  IGL_INLINE void principal_matching(const MeshTopology& mesh,
+                                     const Eigen::MatrixXd& rawField,
+                                     Eigen::VectorXi& matching,
+                                     Eigen::VectorXd& effort,
+                                     Eigen::VectorXi& singVertices,
+                                     Eigen::VectorXi& singIndices)
+  {
+    principal_matching(mesh.EF, mesh.B1, mesh.B2, mesh.edgeTransport, rawField, matching, effort);
+    effort_to_indices(mesh, effort, matching, rawField.cols()/3, singVertices, singIndices);
+  }
+  
+  //Version with a field in tangent form and a precomputed mesh topology
+  IGL_INLINE void principal_matching(const MeshTopology& mesh,
+                                     const TangentField& tangentField,
+                                     Eigen::VectorXi& matching,
+                                     Eigen::VectorXd& effort,
+                                     Eigen::VectorXi& singVertices,
+                                     Eigen::VectorXi& singIndices)
+  {
+    principal_matching(mesh.EF, mesh.edgeTransport, tangentField, matching, effort);
+    effort_to_indices(mesh, effort, matching, tangentField.N(), singVertices, singIndices);
   }
   
   //Version with representative vector (for N-RoSy alone) as input.
@@ -138,6 +233,20 @@ namespace directional
     representative_to_raw(V, F, representativeField, N, rawField);
     principal_matching(V, F, EV, EF, FE, rawField, matching, effort, singVertices, singIndices);
   }
+  
+  //Version with representative vector and a precomputed mesh topology
+  IGL_INLINE void principal_matching(const MeshTopology& mesh,
+                                     const Eigen::MatrixXd& representativeField,
+                                     const int N,
+                                     Eigen::VectorXi& matching,
+                                     Eigen::VectorXd& effort,
+                                     Eigen::VectorXi& singVertices,
+                                     Eigen::VectorXi& singIndices)
+  {
+    Eigen::MatrixXd rawField;
+    representative_to_raw(mesh.V, mesh.F, representativeField, N, rawField);
+    principal_matching(mesh, rawField, matching, effort, singVertices, singIndices);
+  }
 }
 
 
@@ -0,0 +1,121 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2021 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef DIRECTIONAL_READ_FIELD_BUNDLE_H
+#define DIRECTIONAL_READ_FIELD_BUNDLE_H
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <type_traits>
+#include <Eigen/Core>
+#include <igl/igl_inline.h>
+#include <directional/FieldBundle.h>
+#include <directional/crc32.h>
+
+namespace directional
+{
+  
+  // Reads the header and the chunk table of a field bundle file (see directional::FieldBundle), without reading any payload.
+  // Returns:
+  //   Whether the file could be opened and has a valid header and table.
+  bool IGL_INLINE read_field_bundle_table(const std::string& fileName,
+                                          FieldBundle::Header& header,
+                                          std::vector<FieldBundle::ChunkEntry>& table)
+  {
+    std::ifstream f(fileName, std::ios::binary);
+    if (!f.is_open())
+      return false;
+    f.read(reinterpret_cast<char*>(&header), sizeof(FieldBundle::Header));
+    if (!f.good() || !header.is_valid())
+      return false;
+    f.seekg(0, std::ios::end);
+    std::streamoff fileSize=f.tellg();
+    f.seekg(sizeof(FieldBundle::Header));
+    if ((fileSize<0)||(header.numChunks>(std::uint64_t(fileSize)-sizeof(FieldBundle::Header))/sizeof(FieldBundle::ChunkEntry)))
+      return false;
+    table.resize(header.numChunks);
+    if (header.numChunks>0)
+      f.read(reinterpret_cast<char*>(table.data()), header.numChunks*sizeof(FieldBundle::ChunkEntry));
+    return !f.fail();
+  }
+  
+  
+  // Reads the payload of one chunk into m, and verifies its type, size, and checksum.
+  // The chunk is rejected before allocating if its dimensions overflow or its payload does not fit in a file of fileSize bytes.
+  template<typename Derived>
+  IGL_INLINE bool read_field_bundle_chunk(std::ifstream& f,
+                                          const std::uint64_t fileSize,
+                                          const FieldBundle::ChunkEntry& entry,
+                                          Eigen::PlainObjectBase<Derived>& m)
+  {
+    typedef typename Derived::Scalar Scalar;
+    FieldBundle::ChunkType type = (std::is_same<Scalar,double>::value ? FieldBundle::CHUNK_DOUBLE : FieldBundle::CHUNK_INT32);
+    if ((entry.type!=type)||(entry.offset>fileSize)||(entry.size>fileSize-entry.offset))
+      return false;
+    if ((entry.cols!=0)&&(entry.rows>entry.size/sizeof(Scalar)/entry.cols))
+      return false;
+    if (entry.size!=entry.rows*entry.cols*sizeof(Scalar))
+      return false;
+    if ((Derived::ColsAtCompileTime==1)&&(entry.cols!=1))
+      return false;
+    m.resize(entry.rows, entry.cols);
+    f.seekg(entry.offset);
+    f.read(reinterpret_cast<char*>(m.data()), entry.size);
+    return (!f.fail()) && (crc32(m.data(), entry.size)==entry.checksum);
+  }
+  
+  
+  // Reads a field bundle written by directional::write_field_bundle. Every chunk is read with a single seek and bulk read, and verified by its checksum.
+  // Inputs:
+  //   fileName:  The to be loaded file.
+  //   chunkMask: The chunks to read, as an OR of FieldBundle::chunk_bit() (all by default). The other members are left empty, and their payload is not touched.
+  // Outputs:
+  //   bundle:    The read members; members whose chunk is absent from the file are empty.
+  // Return:
+  //   Whether or not the file was read successfully (false if any requested chunk is corrupt)
+  bool IGL_INLINE read_field_bundle(const std::string& fileName,
+                                    FieldBundle& bundle,
+                                    const unsigned int chunkMask=FieldBundle::ALL_CHUNKS)
+  {
+    FieldBundle::Header header;
+    std::vector<FieldBundle::ChunkEntry> table;
+    if (!read_field_bundle_table(fileName, header, table))
+      return false;
+    
+    bundle=FieldBundle();
+    bundle.N=header.N;
+    std::ifstream f(fileName, std::ios::binary);
+    if (!f.is_open())
+      return false;
+    f.seekg(0, std::ios::end);
+    std::streamoff fileSize=f.tellg();
+    if (fileSize<0)
+      return false;
+    
+    for (size_t i=0;i<table.size();i++){
+      if ((table[i].id>=32)||!(chunkMask & FieldBundle::chunk_bit((FieldBundle::ChunkId)table[i].id)))
+        continue;
+      bool success=true;
+      switch (table[i].id){
+        case FieldBundle::RAW_FIELD: success=read_field_bundle_chunk(f, fileSize, table[i], bundle.rawField); break;
+        case FieldBundle::MATCHING: success=read_field_bundle_chunk(f, fileSize, table[i], bundle.matching); break;
+        case FieldBundle::EFFORT: success=read_field_bundle_chunk(f, fileSize, table[i], bundle.effort); break;
+        case FieldBundle::SING_VERTICES: success=read_field_bundle_chunk(f, fileSize, table[i], bundle.singVertices); break;
+        case FieldBundle::SING_INDICES: success=read_field_bundle_chunk(f, fileSize, table[i], bundle.singIndices); break;
+        case FieldBundle::COMBED_FIELD: success=read_field_bundle_chunk(f, fileSize, table[i], bundle.combedField); break;
+        case FieldBundle::COMBED_MATCHING: success=read_field_bundle_chunk(f, fileSize, table[i], bundle.combedMatching); break;
+        case FieldBundle::FACE_IS_CUT: success=read_field_bundle_chunk(f, fileSize, table[i], bundle.faceIsCut); break;
+        default: break;  //unknown chunk from a newer writer
+      }
+      if (!success)
+        return false;
+    }
+    return true;
+  }
+}
+
+#endif
@@ -12,12 +12,14 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fstream>
+#include <directional/read_raw_field_binary.h>
 
 
 namespace directional
 {
   
   // Reads a raw field from a file
+  // Both the ASCII format and the binary format (see directional::write_raw_field_binary) are accepted, and told apart by the header.
   // Inputs:
   //   fileName: The to be loaded file.
   // Outputs:
@@ -29,6 +31,10 @@ namespace directional
                                  int& N,
                                  Eigen::MatrixXd& rawField)
   {
+    RawFieldHeader header;
+    if (read_raw_field_header(fileName, header))
+      return read_raw_field_binary(fileName, N, rawField);
+    
     try
     {
       std::ifstream f(fileName);
@@ -38,7 +44,7 @@ namespace directional
       int numF;
       f>>N;
       f>>numF;
-      rawField.conservativeResize(numF, 3*N);
+      rawField.resize(numF, 3*N);
       
       //Can we do better than element-wise reading?
       for (int i=0;i<rawField.rows();i++)
@@ -48,7 +54,7 @@ namespace directional
       f.close();
       return f.good();
     }
-    catch (std::exception e)
+    catch (const std::exception&)
     {
       return false;
     }
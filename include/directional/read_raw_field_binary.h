@@ -0,0 +1,98 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2021 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef DIRECTIONAL_READ_RAW_FIELD_BINARY_H
+#define DIRECTIONAL_READ_RAW_FIELD_BINARY_H
+
+#include <type_traits>
+#include <Eigen/Core>
+#include <string>
+#include <fstream>
+#include <igl/igl_inline.h>
+#include <directional/RawFieldHeader.h>
+
+
+namespace directional
+{
+  
+  // Reads the header of a binary raw field file (see directional::RawFieldHeader).
+  // Returns:
+  //   Whether the file could be opened and starts with a valid header.
+  bool IGL_INLINE read_raw_field_header(const std::string& fileName,
+                                        RawFieldHeader& header)
+  {
+    std::ifstream f(fileName, std::ios::binary);
+    if (!f.is_open())
+      return false;
+    f.read(reinterpret_cast<char*>(&header), sizeof(RawFieldHeader));
+    return f.good() && header.is_valid();
+  }
+  
+  
+  // Reads the payload of a binary raw field file, stored with FileScalar in the layout given by header, into rawField (converting if needed). The stream must be at the payload offset.
+  // Returns false without allocating if the payload given by the header does not fit in the file.
+  template<typename FileScalar, typename Scalar>
+  bool IGL_INLINE read_raw_field_payload(std::ifstream& f,
+                                         const RawFieldHeader& header,
+                                         Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>& rawField)
+  {
+    using namespace Eigen;
+    std::streampos payloadPos=f.tellg();
+    f.seekg(0, std::ios::end);
+    std::streampos fileSize=f.tellg();
+    f.seekg(payloadPos);
+    if ((payloadPos<0) || (fileSize<0) || !f.good() || !header.fits_in(std::uint64_t(fileSize)))
+      return false;
+    
+    if (std::is_same<FileScalar,Scalar>::value && header.layout==RawFieldHeader::COLUMN_MAJOR){  //directly into the output
+      rawField.resize(header.numFaces, 3*header.N);
+      f.read(reinterpret_cast<char*>(rawField.data()), header.payload_size());
+    } else if (header.layout==RawFieldHeader::ROW_MAJOR){
+      Matrix<FileScalar, Dynamic, Dynamic, RowMajor> buffer(header.numFaces, 3*header.N);
+      f.read(reinterpret_cast<char*>(buffer.data()), header.payload_size());
+      rawField = buffer.template cast<Scalar>();
+    } else {
+      Matrix<FileScalar, Dynamic, Dynamic> buffer(header.numFaces, 3*header.N);
+      f.read(reinterpret_cast<char*>(buffer.data()), header.payload_size());
+      rawField = buffer.template cast<Scalar>();
+    }
+    return !f.fail();
+  }
+  
+  
+  // Reads a raw field from a binary file into memory, with one bulk read of the payload.
+  // The field is converted when the scalar type or the layout of the file differ from those of rawField. To avoid the copy altogether, see directional::MappedRawField.
+  // Inputs:
+  //   fileName: The to be loaded file.
+  // Outputs:
+  //   N: The degree of the field
+  //   rawField: the read field in raw #F by 3*N xyzxyz format
+  // Return:
+  //   Whether or not the file was read successfully
+  template<typename Scalar>
+  bool IGL_INLINE read_raw_field_binary(const std::string& fileName,
+                                        int& N,
+                                        Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>& rawField)
+  {
+    std::ifstream f(fileName, std::ios::binary);
+    if (!f.is_open())
+      return false;
+    
+    RawFieldHeader header;
+    f.read(reinterpret_cast<char*>(&header), sizeof(RawFieldHeader));
+    if (!f.good() || !header.is_valid())
+      return false;
+    f.seekg(header.payloadOffset);
+    
+    N=header.N;
+    if (header.scalarType==RawFieldHeader::SCALAR_FLOAT)
+      return read_raw_field_payload<float>(f, header, rawField);
+    else
+      return read_raw_field_payload<double>(f, header, rawField);
+  }
+}
+
+#endif
@@ -19,6 +19,36 @@
 namespace directional
 {
   
+  // The kernel of representative_to_raw() for a degree NT that is known at compile time, or Eigen::Dynamic for any degree N.
+  // The N rotations about the normal share the same angles on all faces, so their sines and cosines are computed once (Rodrigues' formula) instead of building a rotation matrix per face.
+  template<int NT>
+  IGL_INLINE void representative_to_raw_degree(const Eigen::MatrixXd& normals,
+                                               const Eigen::MatrixXd& representative,
+                                               const int N,
+                                               Eigen::MatrixXd& raw)
+  {
+    const int n = (NT==Eigen::Dynamic ? N : NT);
+    raw.conservativeResize(representative.rows(), 3 * n);
+    
+    Eigen::Matrix<double, NT, 1> cosAngles, sinAngles;
+    cosAngles.resize(n);
+    sinAngles.resize(n);
+    for (int j = 0; j < n; j++){
+      cosAngles(j) = cos((2.0*igl::PI*(double)j)/(double)n);
+      sinAngles(j) = sin((2.0*igl::PI*(double)j)/(double)n);
+    }
+    
+    for (int i = 0; i < representative.rows(); i++)
+    {
+      Eigen::RowVector3d vec = representative.row(i);
+      Eigen::RowVector3d normal = normals.row(i);
+      Eigen::RowVector3d normalCrossVec = normal.cross(vec);
+      double normalDotVec = normal.dot(vec);
+      for (int j = 0; j < n; j++)
+        raw.block<1, 3>(i, j * 3) = cosAngles(j)*vec + sinAngles(j)*normalCrossVec + ((1.0-cosAngles(j))*normalDotVec)*normal;
+    }
+  }
+  
   // Convertes an N-RoSy field in representative format to raw format
   // This version accepts the face-based normals as input, instead of (V,F).
   // Input:
@@ -32,18 +62,13 @@ namespace directional
                                         const int N,
                                         Eigen::MatrixXd& raw)
   {
-    raw.conservativeResize(representative.rows(), 3 * N);
-    
-    for (int i = 0; i < representative.rows(); i++)
-    {
-      raw.block<1, 3>(i, 0) << representative.row(i);
-      
-      Eigen::MatrixXd rot = Eigen::AngleAxisd((2.0*igl::PI)/(double)N, normals.row(i)).toRotationMatrix().transpose();
-      for (int j = 1; j < N; j++)
-        raw.block<1, 3>(i, j * 3) << raw.block<1, 3>(i, (j - 1) * 3)*rot;
-      
+    switch (N){
+      case 1: representative_to_raw_degree<1>(normals, representative, N, raw); break;
+      case 2: representative_to_raw_degree<2>(normals, representative, N, raw); break;
+      case 4: representative_to_raw_degree<4>(normals, representative, N, raw); break;
+      case 6: representative_to_raw_degree<6>(normals, representative, N, raw); break;
+      default: representative_to_raw_degree<Eigen::Dynamic>(normals, representative, N, raw);
     }
-    
   }
   
   ///version that accepts (V,F) instead of normals
@@ -15,6 +15,7 @@
 #include <igl/gaussian_curvature.h>
 #include <igl/local_basis.h>
 #include <igl/edge_topology.h>
+#include <directional/MeshTopology.h>
 
 
 namespace directional
@@ -110,6 +111,16 @@ namespace directional
     directional::rotation_to_representative(V, F, EV, EF, B1, B2, rotationAngles, N, globalRotation, representative);
   }
   
+  //Version with a precomputed mesh topology (see directional::MeshTopology)
+  IGL_INLINE void rotation_to_representative(const MeshTopology& mesh,
+                                             const Eigen::VectorXd& rotationAngles,
+                                             const int N,
+                                             const double globalRotation,
+                                             Eigen::MatrixXd& representative)
+  {
+    directional::rotation_to_representative(mesh.V, mesh.F, mesh.EV, mesh.EF, mesh.B1, mesh.B2, rotationAngles, N, globalRotation, representative);
+  }
+  
 }
 
 #endif
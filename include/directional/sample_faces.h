@@ -0,0 +1,147 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2021 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef DIRECTIONAL_SAMPLE_FACES_H
+#define DIRECTIONAL_SAMPLE_FACES_H
+
+#include <vector>
+#include <Eigen/Core>
+#include <igl/igl_inline.h>
+
+namespace directional
+{
+  // The dual graph of a mesh (faces adjacent through inner edges) in compressed rows: the neighbors of face f are adjFaces[adjStart[f]..adjStart[f+1]).
+  IGL_INLINE void dual_adjacency(const int numFaces,
+                                 const Eigen::MatrixXi& EF,
+                                 std::vector<int>& adjStart,
+                                 std::vector<int>& adjFaces)
+  {
+    adjStart.assign(numFaces+1,0);
+    for (int i=0;i<EF.rows();i++)
+      if ((EF(i,0)!=-1)&&(EF(i,1)!=-1)){
+        adjStart[EF(i,0)+1]++;
+        adjStart[EF(i,1)+1]++;
+      }
+    for (int i=0;i<numFaces;i++)
+      adjStart[i+1]+=adjStart[i];
+    adjFaces.resize(adjStart[numFaces]);
+    std::vector<int> fill(adjStart.begin(), adjStart.end()-1);
+    for (int i=0;i<EF.rows();i++)
+      if ((EF(i,0)!=-1)&&(EF(i,1)!=-1)){
+        adjFaces[fill[EF(i,0)]++]=EF(i,1);
+        adjFaces[fill[EF(i,1)]++]=EF(i,0);
+      }
+  }
+
+
+  // Samples faces by ring exclusion: the faces are visited in order, and a face becomes a sample unless it is at most ringDistance faces (through inner edges) away from an earlier sample.
+  // The exclusion zone of every sample is found by a breadth-first search bounded by ringDistance, so the cost is proportional to the number of faces times the size of a ring, and no matrix powers are formed.
+  // Input:
+  //   F              #F by 3 face vertex indices
+  //   EF             #E by 2 edge-face adjacency (-1 on the boundary)
+  //   ringDistance   the exclusion radius in faces (0 samples every face)
+  // Output:
+  //   samples        indices of the sampled faces, in increasing order
+  IGL_INLINE void sample_faces(const Eigen::MatrixXi& F,
+                               const Eigen::MatrixXi& EF,
+                               const int ringDistance,
+                               Eigen::VectorXi& samples)
+  {
+    std::vector<int> adjStart, adjFaces;
+    dual_adjacency(F.rows(), EF, adjStart, adjFaces);
+
+    std::vector<char> occupied(F.rows(),0);
+    std::vector<int> ringLevel(F.rows(),-1);   //distance from the current sample, valid where visitStamp is the current sample
+    std::vector<int> visitStamp(F.rows(),-1);  //the last sample whose search reached each face, so that the arrays are never cleared
+    std::vector<int> samplesList, queue;
+    for (int i=0;i<F.rows();i++){
+      if (occupied[i])
+        continue;
+      samplesList.push_back(i);
+      occupied[i]=1;
+
+      //clearing out the ring
+      queue.clear();
+      queue.push_back(i);
+      visitStamp[i]=i;
+      ringLevel[i]=0;
+      for (size_t q=0;q<queue.size();q++){
+        int f=queue[q];
+        if (ringLevel[f]==ringDistance)
+          continue;
+        for (int a=adjStart[f];a<adjStart[f+1];a++){
+          int g=adjFaces[a];
+          if (visitStamp[g]==i)
+            continue;
+          visitStamp[g]=i;
+          ringLevel[g]=ringLevel[f]+1;
+          occupied[g]=1;
+          queue.push_back(g);
+        }
+      }
+    }
+
+    samples = Eigen::Map<Eigen::VectorXi, Eigen::Unaligned>(samplesList.data(), samplesList.size());
+  }
+
+
+  // Poisson-disk sampling of faces: the faces are visited in order, and a face becomes a sample unless its barycenter is geodesically closer than radius to the barycenter of an earlier sample.
+  // The geodesic ball of a sample is approximated by the part of the Euclidean ball that is connected to it through adjacent faces, which is found by a search that does not leave the ball.
+  // It is exact for radii that are small relative to the curvature, and (unlike a Euclidean ball) does not reach across narrow gaps of the surface.
+  // Input:
+  //   V              #V by 3 vertex coordinates
+  //   F              #F by 3 face vertex indices
+  //   EF             #E by 2 edge-face adjacency (-1 on the boundary)
+  //   radius         the minimal distance between samples
+  // Output:
+  //   samples        indices of the sampled faces, in increasing order
+  IGL_INLINE void sample_faces(const Eigen::MatrixXd& V,
+                               const Eigen::MatrixXi& F,
+                               const Eigen::MatrixXi& EF,
+                               const double radius,
+                               Eigen::VectorXi& samples)
+  {
+    std::vector<int> adjStart, adjFaces;
+    dual_adjacency(F.rows(), EF, adjStart, adjFaces);
+
+    Eigen::MatrixXd barycenters(F.rows(),3);
+    for (int i=0;i<F.rows();i++)
+      barycenters.row(i)=(V.row(F(i,0))+V.row(F(i,1))+V.row(F(i,2)))/3.0;
+
+    std::vector<char> occupied(F.rows(),0);
+    std::vector<int> visitStamp(F.rows(),-1);  //the last sample whose search reached each face, so that the array is never cleared
+    std::vector<int> samplesList, queue;
+    for (int i=0;i<F.rows();i++){
+      if (occupied[i])
+        continue;
+      samplesList.push_back(i);
+      occupied[i]=1;
+
+      //clearing out the ball
+      queue.clear();
+      queue.push_back(i);
+      visitStamp[i]=i;
+      for (size_t q=0;q<queue.size();q++){
+        int f=queue[q];
+        for (int a=adjStart[f];a<adjStart[f+1];a++){
+          int g=adjFaces[a];
+          if (visitStamp[g]==i)
+            continue;
+          visitStamp[g]=i;
+          if ((barycenters.row(g)-barycenters.row(i)).squaredNorm()>=radius*radius)
+            continue;
+          occupied[g]=1;
+          queue.push_back(g);
+        }
+      }
+    }
+
+    samples = Eigen::Map<Eigen::VectorXi, Eigen::Unaligned>(samplesList.data(), samplesList.size());
+  }
+}
+
+#endif
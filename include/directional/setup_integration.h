@@ -23,6 +23,8 @@
 #include <directional/dcel.h>
 #include <directional/cut_mesh_with_singularities.h>
 #include <directional/combing.h>
+#include <directional/face_components.h>
+#include <directional/MeshTopology.h>
 
 namespace directional
 {
@@ -123,8 +125,8 @@ namespace directional
   //  intData:      updated integration data.
   //  cutV:         the Vertices of the cut mesh.
   //  cutF:         the Faces of the cut mesh (1-1 correspondence with wholeF, but vertices indexed into cutV).
-  //  combedField:  The raw field combed into N different fields on the cut mesh (every column is a single-vf).
-  //  combedMatching: the new matching of the combed field when given on the whole mesh (mostly zero except on cuts).
+  //  combedView:   The raw field combed into N different fields on the cut mesh (every column is a single-vf), as a view of rawField (see directional::CombedFieldView), with
+  //                the new matching of the combed field when given on the whole mesh (mostly zero except on cuts). rawField must outlive it.
   
   IGL_INLINE void setup_integration(const Eigen::MatrixXd& wholeV,
                                     const Eigen::MatrixXi& wholeF,
@@ -137,16 +139,16 @@ namespace directional
                                     IntegrationData& intData,
                                     Eigen::MatrixXd& cutV,
                                     Eigen::MatrixXi& cutF,
-                                    Eigen::MatrixXd& combedField,
-                                    Eigen::VectorXi& combedMatching)
+                                    CombedFieldView& combedView)
   {
     
     using namespace Eigen;
     using namespace std;
     
-    //cutting mesh and combing field.
+    //cutting mesh and combing field (only the face turns; the field is not copied).
     cut_mesh_with_singularities(wholeV, wholeF, singVertices, intData.face2cut);
-    combing(wholeV,wholeF, EV, EF, FE, intData.face2cut, rawField, matching, combedField, combedMatching);
+    combing(EF, FE, intData.face2cut, rawField, matching, combedView);
+    const VectorXi& combedMatching=combedView.combedMatching;
     
     MatrixXi EFi,EH, FH;
     MatrixXd FEs;
@@ -629,20 +631,34 @@ namespace directional
     for(int i = 0; i < numTransitions; i++)
       intData.integerVars(i) = wholeV.rows() + i;
     
-    //fixed values
-    intData.fixedIndices.resize(intData.n);
-    if (isSingular.sum()==0){  //no inner singular vertices; vertex 0 is set to (0....0)
-      for (int j=0;j<intData.n;j++)
-        intData.fixedIndices(j)=j;
-    }else {  //fixing first singularity to (0.5,....0.5)
-      int firstSing;
-      for (firstSing=0;firstSing<isSingular.size();firstSing++)
-        if (isSingular(firstSing))
-          break;
-      //firstSing=0; //like before
+    //fixed values: the translation is free in every connected component, so one vertex per component is fixed
+    VectorXi faceComponents;
+    int numComponents=face_components(EF, wholeF.rows(), faceComponents);
+    VectorXi componentFixedVertex=VectorXi::Constant(numComponents,-1);
+    VectorXi componentFixedSingular=VectorXi::Zero(numComponents);
+    for (int i=0;i<wholeF.rows();i++)
+      for (int j=0;j<3;j++){
+        int v=wholeF(i,j);
+        int c=faceComponents(i);
+        if ((isSingular(v))&&((!componentFixedSingular(c))||(v<componentFixedVertex(c)))){  //fixing the first singularity of the component
+          componentFixedVertex(c)=v;
+          componentFixedSingular(c)=1;
+        } else if ((!componentFixedSingular(c))&&((componentFixedVertex(c)==-1)||(v<componentFixedVertex(c))))  //no inner singular vertices; the first vertex of the component
+          componentFixedVertex(c)=v;
+      }
+    
+    vector<int> fixedVertices;
+    VectorXi isFixed=VectorXi::Zero(wholeV.rows());
+    for (int c=0;c<numComponents;c++)
+      if (!isFixed(componentFixedVertex(c))){  //components that touch at a vertex share its variables
+        isFixed(componentFixedVertex(c))=1;
+        fixedVertices.push_back(componentFixedVertex(c));
+      }
+    
+    intData.fixedIndices.resize(intData.n*fixedVertices.size());
+    for (size_t i=0;i<fixedVertices.size();i++)
       for (int j=0;j<intData.n;j++)
-        intData.fixedIndices(j)=intData.n*firstSing+j;
-    }
+        intData.fixedIndices(intData.n*i+j)=intData.n*fixedVertices[i]+j;
     
     //creating list of singular corners and singular integer matrix
     VectorXi singularIndices(intData.n * isSingular.sum());
@@ -684,10 +700,60 @@ namespace directional
     intData.singIntSpanMatInteger.setFromTriplets(singIntSpanMatTripletsInteger.begin(), singIntSpanMatTripletsInteger.end());
     
     intData.singularIndices=singularIndices;
-    intData.fixedValues.resize(intData.n);
+    intData.fixedValues.resize(intData.fixedIndices.size());
     intData.fixedValues.setConstant(0);
     
   }
+  
+  //Version that outputs the combed field as a copy
+  //  combedField:  The raw field combed into N different fields on the cut mesh (every column is a single-vf).
+  //  combedMatching: the new matching of the combed field when given on the whole mesh (mostly zero except on cuts).
+  IGL_INLINE void setup_integration(const Eigen::MatrixXd& wholeV,
+                                    const Eigen::MatrixXi& wholeF,
+                                    const Eigen::MatrixXi& EV,
+                                    const Eigen::MatrixXi& EF,
+                                    const Eigen::MatrixXi& FE,
+                                    const Eigen::MatrixXd& rawField,
+                                    const Eigen::VectorXi& matching,
+                                    const Eigen::VectorXi& singVertices,
+                                    IntegrationData& intData,
+                                    Eigen::MatrixXd& cutV,
+                                    Eigen::MatrixXi& cutF,
+                                    Eigen::MatrixXd& combedField,
+                                    Eigen::VectorXi& combedMatching)
+  {
+    CombedFieldView combedView;
+    setup_integration(wholeV, wholeF, EV, EF, FE, rawField, matching, singVertices, intData, cutV, cutF, combedView);
+    combedView.materialize(combedField);
+    combedMatching=combedView.combedMatching;
+  }
+  
+  //Version with a precomputed mesh topology that outputs a view of the combed field (see directional::CombedFieldView)
+  IGL_INLINE void setup_integration(const MeshTopology& mesh,
+                                    const Eigen::MatrixXd& rawField,
+                                    const Eigen::VectorXi& matching,
+                                    const Eigen::VectorXi& singVertices,
+                                    IntegrationData& intData,
+                                    Eigen::MatrixXd& cutV,
+                                    Eigen::MatrixXi& cutF,
+                                    CombedFieldView& combedView)
+  {
+    setup_integration(mesh.V, mesh.F, mesh.EV, mesh.EF, mesh.FE, rawField, matching, singVertices, intData, cutV, cutF, combedView);
+  }
+  
+  //Version with a precomputed mesh topology (see directional::MeshTopology)
+  IGL_INLINE void setup_integration(const MeshTopology& mesh,
+                                    const Eigen::MatrixXd& rawField,
+                                    const Eigen::VectorXi& matching,
+                                    const Eigen::VectorXi& singVertices,
+                                    IntegrationData& intData,
+                                    Eigen::MatrixXd& cutV,
+                                    Eigen::MatrixXi& cutF,
+                                    Eigen::MatrixXd& combedField,
+                                    Eigen::VectorXi& combedMatching)
+  {
+    setup_integration(mesh.V, mesh.F, mesh.EV, mesh.EF, mesh.FE, rawField, matching, singVertices, intData, cutV, cutF, combedField, combedMatching);
+  }
 }
 
 #endif
@@ -0,0 +1,168 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2021 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef DIRECTIONAL_SMALLEST_EIGENVECTOR_H
+#define DIRECTIONAL_SMALLEST_EIGENVECTOR_H
+
+#include <cmath>
+#include <algorithm>
+#include <complex>
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+#include <Eigen/SparseCholesky>
+#include <Eigen/Eigenvalues>
+#include <igl/igl_inline.h>
+
+
+namespace directional {
+
+  // The cached data for finding the smallest eigenpair of a generalized Hermitian problem Q*u = s*M*u, where Q is positive semi-definite and M is positive definite (e.g., a mass matrix).
+  // The system is solved directly in complex arithmetic by shift-invert Lanczos iterations, where (Q-sigma*M) is factorized once and reused for all iterations (and for subsequent calls).
+  // Scalar is the precision of the matrices and of the Lanczos vectors; the default tolerance is relaxed accordingly for float.
+  template<typename Scalar>
+  struct SmallestEigDataT{
+  public:
+
+    typedef std::complex<Scalar> Complex;
+    typedef Eigen::Matrix<Complex, Eigen::Dynamic, 1> VectorXc;
+    typedef Eigen::Matrix<Complex, Eigen::Dynamic, Eigen::Dynamic> MatrixXc;
+
+    Eigen::SparseMatrix<Complex> M;    //The mass matrix
+    double sigma;                      //The shift (slightly below zero so that Q-sigma*M is positive definite even when Q is singular)
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<Complex>> solver;   //factorization of Q-sigma*M
+    bool factorized;
+
+    double tolerance;             //Relative tolerance on the residual of the eigenpair
+    int subspaceSize;             //Number of Lanczos vectors between restarts
+    int maxIterations;            //Maximum number of restarts
+
+    SmallestEigDataT():sigma(0.0), factorized(false), tolerance(std::max(1e-8, 1e3*(double)Eigen::NumTraits<Scalar>::epsilon())), subspaceSize(20), maxIterations(100){}
+    //A copy has the parameters but not the factorization (the solver is not copyable), so it must be precomputed again
+    SmallestEigDataT(const SmallestEigDataT& other):sigma(0.0), factorized(false){*this=other;}
+    SmallestEigDataT& operator=(const SmallestEigDataT& other)
+    {
+      tolerance=other.tolerance;
+      subspaceSize=other.subspaceSize;
+      maxIterations=other.maxIterations;
+      factorized=false;
+      return *this;
+    }
+    ~SmallestEigDataT(){}
+  };
+
+  typedef SmallestEigDataT<double> SmallestEigData;
+  typedef SmallestEigDataT<float> SmallestEigDataf;
+
+
+  // Factorizes the shifted system. Must be called again whenever Q or M change.
+  // Input:
+  //  Q: n by n Hermitian positive semi-definite matrix
+  //  M: n by n Hermitian positive definite matrix
+  // Output:
+  //  eigData: the factorized shifted system. Returns false if the factorization failed.
+  template<typename Scalar>
+  IGL_INLINE bool smallest_eigenvector_precompute(const Eigen::SparseMatrix<std::complex<Scalar>>& Q,
+                                                  const Eigen::SparseMatrix<std::complex<Scalar>>& M,
+                                                  SmallestEigDataT<Scalar>& eigData)
+  {
+    using namespace Eigen;
+    typedef std::complex<Scalar> Complex;
+    eigData.M=M;
+
+    //the shift is relative to the average eigenvalue of the pencil, so that it is negligible compared to the spectral gap, but still keeps the factorization stable (it must be above the roundoff of Scalar)
+    double traceQ=0.0, traceM=0.0;
+    for (int i=0;i<Q.rows();i++){
+      traceQ+=std::abs(Q.coeff(i,i));
+      traceM+=std::abs(M.coeff(i,i));
+    }
+    double relativeShift = std::max(1e-8, 10.0*(double)NumTraits<Scalar>::epsilon());
+    eigData.sigma = (traceM>0.0 ? -relativeShift*traceQ/traceM : 0.0);
+
+    SparseMatrix<Complex> shiftedQ = Q - Complex((Scalar)eigData.sigma,0.0)*M;
+    eigData.solver.compute(shiftedQ);
+    eigData.factorized = (eigData.solver.info() == Success);
+    return eigData.factorized;
+  }
+
+
+  // Computes the eigenvector of Q*u = s*M*u with the smallest eigenvalue, by Lanczos iterations on the shift-inverted operator (Q-sigma*M)^{-1}*M, with explicit restarts from the best Ritz vector.
+  // Input:
+  //  eigData: data on which smallest_eigenvector_precompute() has been called.
+  //  u: if of the right size, used as the initial guess (e.g., the result of a previous call).
+  // Output:
+  //  u: n the eigenvector, normalized so that u^H*M*u=1
+  //  s: the eigenvalue.
+  //  Returns whether the residual reached eigData.tolerance within eigData.maxIterations restarts.
+  template<typename Scalar>
+  IGL_INLINE bool smallest_eigenvector(const SmallestEigDataT<Scalar>& eigData,
+                                       Eigen::Matrix<std::complex<Scalar>, Eigen::Dynamic, 1>& u,
+                                       double& s)
+  {
+    using namespace Eigen;
+    using namespace std;
+    typedef complex<Scalar> Complex;
+    typedef typename SmallestEigDataT<Scalar>::VectorXc VectorXc;
+    typedef typename SmallestEigDataT<Scalar>::MatrixXc MatrixXc;
+
+    assert(eigData.factorized && "smallest_eigenvector(): call smallest_eigenvector_precompute() first");
+    int n=eigData.M.rows();
+    int k=std::max(2, std::min(eigData.subspaceSize, n));
+
+    if (u.size()!=n)
+      u=VectorXc::Ones(n)+VectorXd::LinSpaced(n,0.0,1.0).template cast<Complex>()*Complex(0.0,1.0);  //deterministic start with components along most eigenvectors
+
+    u/=sqrt(u.dot(eigData.M*u).real());
+
+    MatrixXc V(n,k+1);
+    VectorXd alpha(k), beta(k);
+    double theta=0.0;
+    for (int iter=0;iter<eigData.maxIterations;iter++){
+      V.col(0)=u;
+      int m=0;
+      for (int j=0;j<k;j++){
+        m=j+1;
+        VectorXc w = eigData.solver.solve(eigData.M*V.col(j));
+        alpha(j)=0.0;
+        //full reorthogonalization in the M-inner product (twice is enough)
+        for (int pass=0;pass<2;pass++){
+          VectorXc h = V.leftCols(j+1).adjoint()*(eigData.M*w);
+          w-=V.leftCols(j+1)*h;
+          alpha(j)+=h(j).real();
+        }
+        beta(j)=sqrt(std::max((double)w.dot(eigData.M*w).real(),0.0));
+        if (beta(j)<=std::max(1e-14, (double)NumTraits<Scalar>::epsilon())*std::abs(alpha(j)))  //invariant subspace
+          break;
+        V.col(j+1)=w/(Scalar)beta(j);
+      }
+
+      //Ritz pairs from the tridiagonal projection; the largest Ritz value of the inverse is the smallest eigenvalue
+      MatrixXd T=MatrixXd::Zero(m,m);
+      for (int j=0;j<m;j++){
+        T(j,j)=alpha(j);
+        if (j<m-1){
+          T(j+1,j)=beta(j);
+          T(j,j+1)=beta(j);
+        }
+      }
+      SelfAdjointEigenSolver<MatrixXd> tEigs(T);
+      theta=tEigs.eigenvalues()(m-1);
+      VectorXd y=tEigs.eigenvectors().col(m-1);
+
+      u=V.leftCols(m)*y.template cast<Complex>();
+      u/=sqrt(u.dot(eigData.M*u).real());
+      s=eigData.sigma+1.0/theta;
+
+      double residual=std::abs(beta(m-1)*y(m-1));
+      if (residual<=eigData.tolerance*std::abs(theta))
+        return true;
+    }
+    return false;
+  }
+}
+
+
+#endif
@@ -6,16 +6,21 @@
 // v. 2.0. If a copy of the MPL was not distributed with this file, You can
 // obtain one at http://mozilla.org/MPL/2.0/.
 
+#include <algorithm>
+#include <limits>
 #include <Eigen/Geometry>
 #include <igl/edge_topology.h>
 #include <igl/sort_vectors_ccw.h>
 #include <igl/per_face_normals.h>
-#include <igl/segment_segment_intersect.h>
 #include <igl/triangle_triangle_adjacency.h>
+#include <igl/local_basis.h>
+#include <igl/doublearea.h>
 #include <igl/barycenter.h>
 #include <igl/slice.h>
-#include <igl/speye.h>
+#include <igl/parallel_for.h>
 #include <directional/principal_matching.h>
+#include <directional/edge_transport.h>
+#include <directional/sample_faces.h>
 #include <directional/streamlines.h>
 
 
@@ -25,58 +30,7 @@ IGL_INLINE void generate_sample_locations(const Eigen::MatrixXi& F,
                                           const int ringDistance,
                                           Eigen::VectorXi& samples)
 {
-  //creating adjacency matrix
-  std::vector<Eigen::Triplet<int>> adjTris;
-  for (int i=0;i<EF.rows();i++)
-    if ((EF(i,0)!=-1)&&(EF(i,1)!=-1)){
-      adjTris.push_back(Eigen::Triplet<int>(EF(i,0), EF(i,1),1));
-      adjTris.push_back(Eigen::Triplet<int>(EF(i,1), EF(i,0),1));
-    }
-  
-  Eigen::SparseMatrix<int> adjMat(F.rows(),F.rows());
-  adjMat.setFromTriplets(adjTris.begin(), adjTris.end());
-  Eigen::SparseMatrix<int> newAdjMat(F.rows(),F.rows()),matMult;
-  igl::speye(F.rows(), F.rows(), matMult);
-  for (int i=0;i<ringDistance;i++){
-    matMult=matMult*adjMat;
-    newAdjMat+=matMult;
-  }
-  
-  //cout<<"newAdjMat: "<<newAdjMat<<endl;
-  
-  adjMat=newAdjMat;
-  
-  std::vector<std::set<int>> ringAdjacencies(F.rows());
-  for (int k=0; k<adjMat.outerSize(); ++k){
-    for (Eigen::SparseMatrix<int>::InnerIterator it(adjMat,k); it; ++it){
-      ringAdjacencies[it.row()].insert(it.col());
-      ringAdjacencies[it.col()].insert(it.row());
-    }
-  }
-
-  Eigen::VectorXi sampleMask=Eigen::VectorXi::Zero(F.rows());
-  for (int i=0;i<F.rows();i++){
-    if (sampleMask(i)!=0) //occupied face
-      continue;
-    
-    sampleMask(i)=2;
-    //clearing out all other faces
-    //cout<<"closeby set to face "<<i<<endl;
-    for (std::set<int>::iterator si=ringAdjacencies[i].begin();si!=ringAdjacencies[i].end();si++){
-      if (sampleMask(*si)==0)
-        sampleMask(*si)=1;
-      //cout<<*si<<" ";
-    }
-    //cout<<endl;
-    
-  }
-  
-  std::vector<int> samplesList;
-  for (int i=0;i<sampleMask.size();i++)
-    if (sampleMask(i)==2)
-      samplesList.push_back(i);
-  
-  samples = Eigen::Map<Eigen::VectorXi, Eigen::Unaligned>(samplesList.data(), samplesList.size());
+  directional::sample_faces(F, EF, ringDistance, samples);
 }
 }
 
@@ -88,24 +42,50 @@ IGL_INLINE void directional::streamlines_init(const Eigen::MatrixXd V,
                                               const int ringDistance,
                                               StreamlineData &data,
                                               StreamlineState &state){
+  //only the members that the tracing reads: the adjacency, the local bases and the edge transport (for the matching), and the face areas; the boundary loops, dual cycles, and combing tree are not computed
+  directional::MeshTopology mesh;
+  mesh.V = V;
+  mesh.F = F;
+  igl::edge_topology(V, F, mesh.EV, mesh.FE, mesh.EF);
+  igl::triangle_triangle_adjacency(F, mesh.TT, mesh.TTi);
+  igl::local_basis(V, F, mesh.B1, mesh.B2, mesh.FN);
+  directional::edge_transport(V, mesh.EV, mesh.EF, mesh.B1, mesh.B2, mesh.edgeVectors, mesh.edgeTransport);
+  Eigen::VectorXd doubleAreas;
+  igl::doublearea(V, F, doubleAreas);
+  mesh.faceAreas = doubleAreas / 2.0;
+  directional::streamlines_init(mesh, temp_field, seedLocations, ringDistance, data, state);
+}
+
+IGL_INLINE void directional::streamlines_init(const MeshTopology& mesh,
+                                              const Eigen::MatrixXd& temp_field,
+                                              const Eigen::VectorXi& seedLocations,
+                                              const int ringDistance,
+                                              StreamlineData &data,
+                                              StreamlineState &state){
   using namespace Eigen;
   using namespace std;
   
-  igl::edge_topology(V, F, data.EV, data.FE, data.EF);
-  igl::triangle_triangle_adjacency(F, data.TT);
+  const Eigen::MatrixXd& V = mesh.V;
+  const Eigen::MatrixXi& F = mesh.F;
+  data.EV = mesh.EV;
+  data.FE = mesh.FE;
+  data.EF = mesh.EF;
+  data.TT = mesh.TT;
+  data.TTi = mesh.TTi;
   
   state.numSteps=0;
+  state.numSegments=0;  //the buffers are kept for reuse
+  state.update_views();
   
   // prepare vector field
   // --------------------------
   int degree = temp_field.cols()/3;
   data.degree = degree;
   
-  Eigen::MatrixXd FN;
+  const Eigen::MatrixXd& FN = mesh.FN;
   Eigen::VectorXi order;
   Eigen::RowVectorXd sorted;
   
-  igl::per_face_normals(V, F, FN);
   data.field.setZero(F.rows(), degree * 3);
   for (unsigned i = 0; i < F.rows(); ++i){
     const Eigen::RowVectorXd &n = FN.row(i);
@@ -121,9 +101,21 @@ IGL_INLINE void directional::streamlines_init(const Eigen::MatrixXd V,
       data.field.block(i, j * 3, 1, 3) = pd;
     }
   }
+  // the gradient of the barycentric coordinate of vertex k is FN x (opposite edge) / (2*area)
+  data.baryGradients.resize(F.rows(), 9);
+  data.baryField.resize(F.rows(), 3 * degree);
+  for (int i = 0; i < F.rows(); ++i){
+    for (int k = 0; k < 3; ++k){
+      Eigen::RowVector3d e = V.row(F(i, (k + 2) % 3)) - V.row(F(i, (k + 1) % 3));
+      data.baryGradients.block<1, 3>(i, 3 * k) = Eigen::RowVector3d(FN.row(i)).cross(e) / (2.0 * mesh.faceAreas(i));
+    }
+    for (int j = 0; j < degree; ++j)
+      for (int k = 0; k < 3; ++k)
+        data.baryField(i, 3 * j + k) = data.baryGradients.block<1, 3>(i, 3 * k).dot(data.field.block<1, 3>(i, 3 * j));
+  }
+  
   Eigen::VectorXd effort;
-  Eigen::VectorXi singIndices, singVertices;
-  directional::principal_matching(V, F, data.EV, data.EF, data.FE, data.field, data.matching, effort, singVertices, singIndices);
+  directional::principal_matching(mesh.EF, mesh.B1, mesh.B2, mesh.edgeTransport, data.field, data.matching, effort);
   
   // create seeds for tracing
   // --------------------------
@@ -165,96 +157,170 @@ IGL_INLINE void directional::streamlines_init(const Eigen::MatrixXd V,
   for (int i = 0; i < nsamples; ++i)
     for (int j = 0; j < degree; ++j)
       state.current_direction(i, j) = j;
+  state.current_entry.setConstant(nsamples, degree, -1);
+  state.end_bary.setConstant(nsamples * degree, 3, 1.0 / 3.0);
   
 }
 
-IGL_INLINE void directional::streamlines_next(
-                                      const Eigen::MatrixXd V,
-                                      const Eigen::MatrixXi F,
-                                      const StreamlineData & data,
-                                      StreamlineState & state
-                                      ){
+IGL_INLINE void directional::streamlines_init(const MeshTopology& mesh,
+                                              const TangentField& tangentField,
+                                              const Eigen::VectorXi& seedLocations,
+                                              const int ringDistance,
+                                              StreamlineData &data,
+                                              StreamlineState &state){
+  Eigen::MatrixXd rawField;
+  tangentField.get_raw(mesh.B1, mesh.B2, rawField);
+  streamlines_init(mesh, rawField, seedLocations, ringDistance, data, state);
+}
+
+
+IGL_INLINE int directional::streamline_face_exit(const Eigen::Vector3d& b,
+                                                 const Eigen::RowVector3d& db,
+                                                 const int entry,
+                                                 double& t,
+                                                 double& u){
+  const double vertexTolerance = 1e-10;     //relative edge parameter under which an exit point is a vertex hit
+  
+  // the ray leaves through the edge (F(f,k),F(f,k+1)) where the coordinate of the opposite vertex k+2 first vanishes; the entry edge is skipped so that a point on it does not leave backwards
+  int k = -1;
+  t = std::numeric_limits<double>::max();
+  for (int ki = 0; ki < 3; ++ki){
+    const int opposite = (ki + 2) % 3;
+    if ((ki == entry) || (db(opposite) >= 0.0))
+      continue;
+    if (b(opposite) / (-db(opposite)) < t){
+      t = b(opposite) / (-db(opposite));
+      k = ki;
+    }
+  }
+  if (k == -1)
+    return -1;
+  
+  // the exit point as a parameter u along the edge
+  const int k1 = (k + 1) % 3;
+  const double bk = std::max(b(k) + t * db(k), 0.0);
+  const double bk1 = std::max(b(k1) + t * db(k1), 0.0);
+  u = (bk + bk1 > 0.0 ? bk1 / (bk + bk1) : 0.5);
+  // vertex hit: snap to the vertex; if the direction leaves through its other edge as well, the next crossing happens at zero distance
+  if (u <= vertexTolerance)
+    u = 0.0;
+  else if (u >= 1.0 - vertexTolerance)
+    u = 1.0;
+  return k;
+}
+
+
+IGL_INLINE void directional::streamline_cross_edge(const Eigen::MatrixXi& F,
+                                                   const StreamlineData& data,
+                                                   const int k,
+                                                   const double u,
+                                                   int& f,
+                                                   int& m,
+                                                   int& entry,
+                                                   Eigen::Vector3d& b){
+  const int degree = data.degree;
+  const int k1 = (k + 1) % 3;
+  
+  // matching direction on next face (matchings can be negative or exceed the degree)
+  int e1 = data.FE(f, k);
+  if (data.EF(e1, 0) == f)
+    m = ((data.matching(e1)+m)%degree+degree)%degree; //m1 = data.match_ab(e1, m0);
+  else
+    m = ((-data.matching(e1)+m)%degree+degree)%degree;  //data.match_ba(e1, m0);
+  const int f1 = data.TT(f, k);
+  if (f1 == -1){
+    b.setZero();
+    b(k) = 1.0 - u;
+    b(k1) = u;
+    f = -1;
+    entry = -1;
+    return;
+  }
+  
+  // the same point in the barycentric coordinates of the next face, which shares the edge (in opposite orientation if the faces are consistently oriented)
+  const int newEntry = data.TTi(f, k);
+  const int newEntry1 = (newEntry + 1) % 3;
+  b.setZero();
+  if (F(f1, newEntry) == F(f, k1)){
+    b(newEntry) = u;
+    b(newEntry1) = 1.0 - u;
+  } else {
+    b(newEntry) = 1.0 - u;
+    b(newEntry1) = u;
+  }
+  entry = newEntry;
+  f = f1;
+}
+
+
+IGL_INLINE void directional::streamlines_next(const Eigen::MatrixXd& V,
+                                              const Eigen::MatrixXi& F,
+                                              const StreamlineData & data,
+                                              StreamlineState & state,
+                                              const int numSteps){
   
   
   using namespace Eigen;
   using namespace std;
   
-  int degree = data.degree;
-  int nsample = data.nsample;
+  if (numSteps<=0)
+    return;
   
-  state.start_point = state.end_point;
-  state.numSteps++;
+  int nsample = data.nsample;
+  int numSeeds = state.end_point.rows();
   
-  Eigen::VectorXi currFace=Eigen::VectorXi::Zero(state.start_point.rows());
-  Eigen::VectorXi currVector=Eigen::VectorXi::Zero(state.start_point.rows());
-  Eigen::VectorXi currTime=Eigen::VectorXi::Zero(state.start_point.rows());
+  //the new segments are written directly to the end of the segment buffers; segment s of seed i in this call is at firstNew+s*numSeeds+i, as with numSteps successive calls
+  int numNewSegments = numSteps*numSeeds;
+  if (state.numSegments+numNewSegments>state.capacity())
+    state.reserve(std::max(state.numSegments+numNewSegments, 2*state.capacity()));
+  int firstNew = state.numSegments;
+  int firstStep = state.numSteps+1;
+  const int maxCrossings = 64;              //bounds the walk around a vertex (e.g., at a singularity)
   
-  for (int i = 0; i < degree; ++i)
-  {
-    for (int j = 0; j < nsample; ++j)
-    {
-      currFace(j + nsample * i)=data.samples(j);
-      currVector(j + nsample * i)=i;
-      currTime(j + nsample * i)=state.numSteps;
-      
-      int f0 = state.current_face(j,i);
-      if (f0 == -1) // reach boundary
-        continue;
-      int m0 = state.current_direction(j, i);
-      
-      // the starting point of the vector
-      const Eigen::RowVector3d &p = state.start_point.row(j + nsample * i);
-      
-      // the direction where we are trying to go
-      const Eigen::RowVector3d &r = data.field.block(f0, 3 * m0, 1, 3);
-      
-      
-      // new state,
-      int f1, m1;
+  //every seed only reads the mesh and the field and writes its own rows of the state, so the seeds are traced independently (and deterministically) in parallel
+  igl::parallel_for(numSeeds, [&](const int seed){
+    int i = seed / nsample;  //the vector of the seed
+    int j = seed % nsample;  //the sample of the seed
+    RowVector3d p = state.end_point.row(seed);
+    RowVector3d prevP = p;
+    int f0 = state.current_face(j,i);
+    int m0 = state.current_direction(j,i);
+    int entry = state.current_entry(j,i);
+    Vector3d b = state.end_bary.row(seed).transpose();
+    
+    for (int step=0;step<numSteps;step++){
+      int segment = firstNew + step*numSeeds + seed;
+      state.origFaceBuffer(segment)=data.samples(j);
+      state.origVectorBuffer(segment)=i;
+      state.timeSignatureBuffer(segment)=firstStep+step;
+      state.P1Buffer.row(segment)=p;
+      prevP = p;
       
-      for (int k = 0; k < 3; ++k)
-      {
-        f1 = data.TT(f0, k);
-        
-        // edge vertices
-        const Eigen::RowVector3d &q = V.row(F(f0, k));
-        const Eigen::RowVector3d &qs = V.row(F(f0, (k + 1) % 3));
-        // edge direction
-        Eigen::RowVector3d s = qs - q;
-        
-        double u;
-        double t;
-        if (igl::segment_segment_intersect(p, r, q, s, t, u, -1e-6))
-        {
-          // point on next face
-          state.end_point.row(j + nsample * i) = p + t * r;
-          state.current_face(j,i) = f1;
-          
-          // matching direction on next face
-          int e1 = data.FE(f0, k);
-          if (data.EF(e1, 0) == f0)
-            m1 = (data.matching(e1)+m0)%data.degree; //m1 = data.match_ab(e1, m0);
-          else
-            m1 = (-data.matching(e1)+m0+data.degree)%data.degree;  //data.match_ba(e1, m0);
-          
-          state.current_direction(j, i) = m1;
+      // crossings at zero distance (walking around a vertex) are part of the same step, so that every step moves forward until the boundary
+      for (int crossing = 0; (f0 != -1) && (crossing < maxCrossings); ++crossing){ // otherwise reached the boundary
+        // the direction where we are trying to go
+        double t, u;
+        const int k = streamline_face_exit(b, data.baryField.block<1, 3>(f0, 3 * m0), entry, t, u);
+        if (k == -1)  // a vanishing direction
           break;
-        }
+        p = (1.0 - u) * V.row(F(f0, k)) + u * V.row(F(f0, (k + 1) % 3));
+        streamline_cross_edge(F, data, k, u, f0, m0, entry, b);
         
+        if (t > 0.0)
+          break;
       }
+      state.P2Buffer.row(segment)=p;
     }
-  }
-  
-  //aggregating
-  state.P1.conservativeResize(state.P1.rows()+state.start_point.rows(),3);
-  state.P2.conservativeResize(state.P2.rows()+state.end_point.rows(),3);
-  state.P1.block(state.P1.rows()-state.start_point.rows(),0,state.start_point.rows(),3)=state.start_point;
-  state.P2.block(state.P2.rows()-state.end_point.rows(),0,state.end_point.rows(),3)=state.end_point;
-  state.origFace.conservativeResize(state.origFace.size()+state.start_point.rows());
-  state.origVector.conservativeResize(state.origVector.size()+state.start_point.rows());
-  state.timeSignature.conservativeResize(state.timeSignature.size()+state.start_point.rows());
-  state.origFace.tail(state.start_point.rows())=currFace;
-  state.origVector.tail(state.end_point.rows())=currVector;
-  state.timeSignature.tail(state.end_point.rows())=currTime;
+    
+    state.start_point.row(seed) = prevP;
+    state.end_point.row(seed) = p;
+    state.current_face(j,i) = f0;
+    state.current_direction(j,i) = m0;
+    state.current_entry(j,i) = entry;
+    state.end_bary.row(seed) = b.transpose();
+  }, 1000);
   
+  state.numSegments+=numNewSegments;
+  state.numSteps+=numSteps;
+  state.update_views();
 }
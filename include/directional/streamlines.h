@@ -13,12 +13,17 @@
 
 #include <Eigen/Core>
 #include <vector>
+#include <new>
+#include <algorithm>
+#include <directional/MeshTopology.h>
+#include <directional/TangentField.h>
 
 namespace directional
 {
   struct StreamlineData
   {
     Eigen::MatrixXi TT;         //  #F by #3 adjacent matrix
+    Eigen::MatrixXi TTi;        //  #F by #3 the edge of TT(f,k) that is shared with f (as in igl::triangle_triangle_adjacency)
     Eigen::MatrixXi EV;          //  #E by #3
     Eigen::MatrixXi FE;        //  #Fx3, Stores the Triangle-Edge relation
     Eigen::MatrixXi EF;        //  #Ex2, Stores the Edge-Triangle relation
@@ -29,6 +34,9 @@ namespace directional
     //      the vector set in a is matched to vector #mab[i] in b)
     // Eigen::MatrixXi match_ba;   //  #E by N matrix, describing the inverse relation to match_ab
     Eigen::VectorXi matching;
+    
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> baryGradients;  //  #F by 9 the gradients of the barycentric coordinates of (F(f,0),F(f,1),F(f,2)) (stacked horizontally)
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> baryField;  //  #F by 3N the per-face vectors as rates of change of the barycentric coordinates of (F(f,0),F(f,1),F(f,2)) (summing to zero), used by the stepping kernel (row-major, so that a face is one contiguous record)
     int nsample;                //  #S, number of sample points
     int degree;                 //  #N, degrees of the vector field
     Eigen::VectorXi samples;    //all original faces
@@ -40,12 +48,74 @@ namespace directional
     Eigen::MatrixXd end_point;          //  #N*S by 3 endpoints points of segment (stacked vertically for each degree)
     Eigen::MatrixXi current_face;       //  #S by N face indices (stacked horizontally for each degree)
     Eigen::MatrixXi current_direction;  //  #S by N field direction indices (stacked horizontally for each degree)
+    Eigen::MatrixXi current_entry;      //  #S by N the edge (F(f,k),F(f,k+1)) of the current face through which it was entered, or -1 for a seed face
+    Eigen::MatrixXd end_bary;           //  #N*S by 3 barycentric coordinates of end_point in the current face
     int numSteps;                       // number of steps taken so far
     
-    Eigen::MatrixXd P1, P2;             //entire set of streamline segments
-    Eigen::VectorXi origFace, origVector; //original vectors from faces
-    Eigen::VectorXi timeSignature;        //time (in steps) of the current segment
+    //The entire set of streamline segments, appended to by every step. The buffers hold capacity() rows, of which only the first numSegments are valid.
+    //They grow geometrically, so that tracing S steps copies O(S) segments in total, or once with reserve_steps() when the number of steps is known.
+    Eigen::MatrixXd P1Buffer, P2Buffer;           //segment start and end points
+    Eigen::VectorXi origFaceBuffer, origVectorBuffer;   //original vectors from faces
+    Eigen::VectorXi timeSignatureBuffer;          //time (in steps) of each segment
+    int numSegments;
+    
+    //Read-only views (no copies) of the valid segments, which are updated by streamlines_init(), streamlines_next() and reserve()
+    typedef Eigen::Map<const Eigen::MatrixXd, 0, Eigen::OuterStride<> > SegmentPoints;
+    typedef Eigen::Map<const Eigen::VectorXi> SegmentIndices;
+    SegmentPoints P1, P2;                         //entire set of streamline segments
+    SegmentIndices origFace, origVector;          //original vectors from faces
+    SegmentIndices timeSignature;                 //time (in steps) of each segment
+    
+    StreamlineState():numSteps(0), numSegments(0), P1(NULL,0,3,Eigen::OuterStride<>(1)), P2(NULL,0,3,Eigen::OuterStride<>(1)), origFace(NULL,0), origVector(NULL,0), timeSignature(NULL,0){}
+    
+    StreamlineState(const StreamlineState& other):P1(NULL,0,3,Eigen::OuterStride<>(1)), P2(NULL,0,3,Eigen::OuterStride<>(1)), origFace(NULL,0), origVector(NULL,0), timeSignature(NULL,0){*this=other;}
+    
+    StreamlineState& operator=(const StreamlineState& other)
+    {
+      start_point=other.start_point;
+      end_point=other.end_point;
+      current_face=other.current_face;
+      current_direction=other.current_direction;
+      current_entry=other.current_entry;
+      end_bary=other.end_bary;
+      numSteps=other.numSteps;
+      P1Buffer=other.P1Buffer;
+      P2Buffer=other.P2Buffer;
+      origFaceBuffer=other.origFaceBuffer;
+      origVectorBuffer=other.origVectorBuffer;
+      timeSignatureBuffer=other.timeSignatureBuffer;
+      numSegments=other.numSegments;
+      update_views();
+      return *this;
+    }
+    
+    int capacity() const {return P1Buffer.rows();}
+    
+    // Makes room for at least numTotalSegments segments, keeping the stored ones.
+    IGL_INLINE void reserve(const int numTotalSegments)
+    {
+      if (numTotalSegments<=capacity())
+        return;
+      P1Buffer.conservativeResize(numTotalSegments, 3);
+      P2Buffer.conservativeResize(numTotalSegments, 3);
+      origFaceBuffer.conservativeResize(numTotalSegments);
+      origVectorBuffer.conservativeResize(numTotalSegments);
+      timeSignatureBuffer.conservativeResize(numTotalSegments);
+      update_views();
+    }
     
+    // Makes room for numMoreSteps further calls to streamlines_next() with the current seeds.
+    IGL_INLINE void reserve_steps(const int numMoreSteps){reserve(numSegments+numMoreSteps*start_point.rows());}
+    
+    // Points the views at the first numSegments rows of the buffers (Eigen's placement-new idiom for rebinding a Map).
+    IGL_INLINE void update_views()
+    {
+      new (&P1) SegmentPoints(P1Buffer.data(), numSegments, 3, Eigen::OuterStride<>(std::max(capacity(),1)));
+      new (&P2) SegmentPoints(P2Buffer.data(), numSegments, 3, Eigen::OuterStride<>(std::max(capacity(),1)));
+      new (&origFace) SegmentIndices(origFaceBuffer.data(), numSegments);
+      new (&origVector) SegmentIndices(origVectorBuffer.data(), numSegments);
+      new (&timeSignature) SegmentIndices(timeSignatureBuffer.data(), numSegments);
+    }
   };
   
   
@@ -68,19 +138,73 @@ namespace directional
                                    StreamlineData &data,
                                    StreamlineState &state);
 
+  // Version with a precomputed mesh topology (see directional::MeshTopology)
+  IGL_INLINE void streamlines_init(const MeshTopology& mesh,
+                                   const Eigen::MatrixXd &rawField,
+                                   const Eigen::VectorXi& seedLocations,
+                                   const int ringDistance,
+                                   StreamlineData &data,
+                                   StreamlineState &state);
+
+  // Version with a field in tangent form (see directional::TangentField) and a precomputed mesh topology
+  IGL_INLINE void streamlines_init(const MeshTopology& mesh,
+                                   const TangentField& tangentField,
+                                   const Eigen::VectorXi& seedLocations,
+                                   const int ringDistance,
+                                   StreamlineData &data,
+                                   StreamlineState &state);
+
 
   
-  // The function computes the next state for each point in the sample
+  // The function computes the next state for each point in the sample, advancing all seeds numSteps steps.
+  // The seeds are traced in parallel; the result is identical to numSteps single-step calls, regardless of the number of threads.
+  // Each step moves a seed to the edge where it exits its face, which is where the first barycentric coordinate vanishes along the field (a closed-form minimum over the three edges).
+  // An exit through a vertex is snapped to it, and the seed walks around the vertex until it enters a face along its direction, so a seed only stops at the boundary (current_face=-1).
   //   V             #V by 3 list of mesh vertex coordinates
   //   F             #F by 3 list of mesh faces
   //   data          struct containing topology information
   //   state         struct containing the state of the tracing
-  IGL_INLINE void streamlines_next(
-                                   const Eigen::MatrixXd V,
-                                   const Eigen::MatrixXi F,
+  //   numSteps      number of steps to advance
+  IGL_INLINE void streamlines_next(const Eigen::MatrixXd& V,
+                                   const Eigen::MatrixXi& F,
                                    const StreamlineData & data,
-                                   StreamlineState & state
-                                   );
+                                   StreamlineState & state,
+                                   const int numSteps=1);
+  
+  // The stepping kernel of streamlines_next(): finds where a ray leaves its face. The point with barycentric coordinates b moves along the barycentric direction db
+  // (e.g., a vector of StreamlineData::baryField, or a tangent vector times StreamlineData::baryGradients) until its first coordinate vanishes.
+  // Input:
+  //   b             barycentric coordinates of the point in its face f
+  //   db            direction as rates of change of the barycentric coordinates (summing to zero)
+  //   entry         the edge (F(f,k),F(f,k+1)) through which the point entered f, which is not an exit, or -1
+  // Output:
+  //   t             ray parameter of the exit point (0 if the point already lies on the exit edge)
+  //   u             parameter of the exit point along the exit edge, snapped to 0 or 1 at a vertex hit
+  //   return        the exit edge k, or -1 if db vanishes
+  IGL_INLINE int streamline_face_exit(const Eigen::Vector3d& b,
+                                      const Eigen::RowVector3d& db,
+                                      const int entry,
+                                      double& t,
+                                      double& u);
+  
+  // Moves a point on the edge k of face f, at parameter u along (F(f,k),F(f,k+1)), to the adjacent face, and updates the direction index by the matching.
+  // At the boundary f becomes -1 and b are the coordinates of the point in the face it left.
+  // Input:
+  //   F             #F by 3 list of mesh faces
+  //   data          the tracing data of streamlines_init()
+  //   k, u          the exit edge and parameter (see streamline_face_exit())
+  // Input/Output:
+  //   f, m          the face and the direction index
+  //   entry         the edge of the new face that was crossed
+  //   b             barycentric coordinates of the point in the new face
+  IGL_INLINE void streamline_cross_edge(const Eigen::MatrixXi& F,
+                                        const StreamlineData& data,
+                                        const int k,
+                                        const double u,
+                                        int& f,
+                                        int& m,
+                                        int& entry,
+                                        Eigen::Vector3d& b);
 }
 
 #include "streamlines.cpp"
@@ -16,16 +16,22 @@ namespace directional
 {
   // Creates a tree from a graph given by the edges in EV
   // edges containing a negative vertex are skipped.
+  // If the graph is not connected, the result is a spanning forest with a tree (and a root) for every connected component.
   // Input:
   //  EV:   #E by 2 list of edges in the graph
   // Output:
   //  tE:   #Te vector of edges (within EV) in the graph.
-  //  tEf:  #V the edges leading to each vertex. -1 for the root
+  //  tEf:  #V the edges leading to each vertex. -1 for the roots, and -2 for vertices without edges
   IGL_INLINE void tree(const Eigen::MatrixXi& EV,
                        Eigen::VectorXi& tE,
                        Eigen::VectorXi& tEf)
   {
     using namespace Eigen;
+    if (EV.size()==0){
+      tE.resize(0);
+      tEf.resize(0);
+      return;
+    }
     int numV=EV.maxCoeff()+1;
     VectorXi Valences=VectorXi::Zero(numV);
     for (int i=0;i<EV.rows();i++){
@@ -53,35 +59,34 @@ namespace directional
     tEf.resize(numV);
     tEf.setConstant(-2);
     int currEdgeIndex=0;
-    int start = 0;
-    
-    //Try to find initial possible root for the tree.
-    while (Valences[start] == 0)
-      if (++start > Valences.size())
-        return;
     
-    edgeVertices.push(std::pair<int, int>(-1, start));
-    do{
-      std::pair<int, int> currEdgeVertex=edgeVertices.front();
-      edgeVertices.pop();
-      if (usedVertices(currEdgeVertex.second))
+    //a root for every component that is not reached by the previous trees
+    for (int start=0;start<numV;start++){
+      if ((Valences[start] == 0)||(usedVertices(start)))
         continue;
+      edgeVertices.push(std::pair<int, int>(-1, start));
+      do{
+        std::pair<int, int> currEdgeVertex=edgeVertices.front();
+        edgeVertices.pop();
+        if (usedVertices(currEdgeVertex.second))
+          continue;
       
-      if (currEdgeVertex.first!=-1)
-        tE(currEdgeIndex++)=currEdgeVertex.first;
-      tEf(currEdgeVertex.second)=currEdgeVertex.first;
-      usedVertices(currEdgeVertex.second)=1;
+        if (currEdgeVertex.first!=-1)
+          tE(currEdgeIndex++)=currEdgeVertex.first;
+        tEf(currEdgeVertex.second)=currEdgeVertex.first;
+        usedVertices(currEdgeVertex.second)=1;
       
-      //inserting the new unused vertices
-      for (int i=0;i<Valences(currEdgeVertex.second);i++){
-        int nextEdge=VE(currEdgeVertex.second, i);
-        int nextVertex=(EV(nextEdge, 0)==currEdgeVertex.second ? EV(nextEdge, 1) : EV(nextEdge, 0));
-        if (!usedVertices(nextVertex))
-          edgeVertices.push(std::pair<int, int>(nextEdge, nextVertex));
-      }
-    }while (edgeVertices.size()!=0);
+        //inserting the new unused vertices
+        for (int i=0;i<Valences(currEdgeVertex.second);i++){
+          int nextEdge=VE(currEdgeVertex.second, i);
+          int nextVertex=(EV(nextEdge, 0)==currEdgeVertex.second ? EV(nextEdge, 1) : EV(nextEdge, 0));
+          if (!usedVertices(nextVertex))
+            edgeVertices.push(std::pair<int, int>(nextEdge, nextVertex));
+        }
+      }while (edgeVertices.size()!=0);
+    }
     
-    tE.conservativeResize(usedVertices.sum() - 1);
+    tE.conservativeResize(currEdgeIndex);
   }
   
 }
@@ -0,0 +1,94 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2021 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef DIRECTIONAL_WRITE_FIELD_BUNDLE_H
+#define DIRECTIONAL_WRITE_FIELD_BUNDLE_H
+
+#include <vector>
+#include <type_traits>
+#include <string>
+#include <fstream>
+#include <Eigen/Core>
+#include <igl/igl_inline.h>
+#include <directional/FieldBundle.h>
+#include <directional/crc32.h>
+
+namespace directional
+{
+
+  // Appends a chunk of a bundle to be written (empty matrices are skipped). The payload is kept by pointer, so m must outlive the writing.
+  template<typename Derived>
+  IGL_INLINE void write_field_bundle_add_chunk(std::vector<FieldBundle::ChunkEntry>& table,
+                                               std::vector<const char*>& payloads,
+                                               const FieldBundle::ChunkId id,
+                                               const Eigen::PlainObjectBase<Derived>& m)
+  {
+    typedef typename Derived::Scalar Scalar;
+    static_assert(std::is_same<Scalar,double>::value || std::is_same<Scalar,int>::value, "write_field_bundle(): chunks are either double or int");
+    if (m.size()==0)
+      return;
+    FieldBundle::ChunkEntry entry;
+    entry.id=id;
+    entry.type=(std::is_same<Scalar,double>::value ? FieldBundle::CHUNK_DOUBLE : FieldBundle::CHUNK_INT32);
+    entry.rows=m.rows();
+    entry.cols=m.cols();
+    entry.offset=0;
+    entry.size=m.size()*sizeof(Scalar);
+    entry.checksum=crc32(m.data(), entry.size);
+    entry.reserved=0;
+    table.push_back(entry);
+    payloads.push_back(reinterpret_cast<const char*>(m.data()));
+  }
+  
+  
+  // Writes a field bundle to a single binary file (see directional::FieldBundle for the format). Only the non-empty members are written.
+  // Inputs:
+  //   fileName: The name of the file
+  //   bundle:   The field and its derived quantities
+  // Returns:
+  //   Whether or not the file was written successfully
+  bool IGL_INLINE write_field_bundle(const std::string& fileName,
+                                     const FieldBundle& bundle)
+  {
+    using namespace std;
+    
+    vector<FieldBundle::ChunkEntry> table;
+    vector<const char*> payloads;
+    write_field_bundle_add_chunk(table, payloads, FieldBundle::RAW_FIELD, bundle.rawField);
+    write_field_bundle_add_chunk(table, payloads, FieldBundle::MATCHING, bundle.matching);
+    write_field_bundle_add_chunk(table, payloads, FieldBundle::EFFORT, bundle.effort);
+    write_field_bundle_add_chunk(table, payloads, FieldBundle::SING_VERTICES, bundle.singVertices);
+    write_field_bundle_add_chunk(table, payloads, FieldBundle::SING_INDICES, bundle.singIndices);
+    write_field_bundle_add_chunk(table, payloads, FieldBundle::COMBED_FIELD, bundle.combedField);
+    write_field_bundle_add_chunk(table, payloads, FieldBundle::COMBED_MATCHING, bundle.combedMatching);
+    write_field_bundle_add_chunk(table, payloads, FieldBundle::FACE_IS_CUT, bundle.faceIsCut);
+    
+    FieldBundle::Header header;
+    header.N=bundle.N;
+    header.numChunks=table.size();
+    std::uint64_t offset=sizeof(FieldBundle::Header)+table.size()*sizeof(FieldBundle::ChunkEntry);
+    for (size_t i=0;i<table.size();i++){
+      table[i].offset=offset;
+      offset+=(table[i].size+7)/8*8;
+    }
+    
+    ofstream f(fileName, ios::binary);
+    if (!f.is_open())
+      return false;
+    f.write(reinterpret_cast<const char*>(&header), sizeof(FieldBundle::Header));
+    if (!table.empty())
+      f.write(reinterpret_cast<const char*>(table.data()), table.size()*sizeof(FieldBundle::ChunkEntry));
+    const char padding[8]={0,0,0,0,0,0,0,0};
+    for (size_t i=0;i<table.size();i++){
+      f.write(payloads[i], table[i].size);
+      f.write(padding, (8-table[i].size%8)%8);
+    }
+    f.close();
+    return !f.fail();
+  }
+}
+
+#endif
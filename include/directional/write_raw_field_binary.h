@@ -0,0 +1,51 @@
+// This file is part of Directional, a library for directional field processing.
+// Copyright (C) 2021 Amir Vaxman <avaxman@gmail.com>
+//
+// This Source Code Form is subject to the terms of the Mozilla Public License
+// v. 2.0. If a copy of the MPL was not distributed with this file, You can
+// obtain one at http://mozilla.org/MPL/2.0/.
+#ifndef DIRECTIONAL_WRITE_RAW_FIELD_BINARY_H
+#define DIRECTIONAL_WRITE_RAW_FIELD_BINARY_H
+
+#include <type_traits>
+#include <Eigen/Core>
+#include <string>
+#include <fstream>
+#include <igl/igl_inline.h>
+#include <directional/RawFieldHeader.h>
+
+namespace directional
+{
+
+  // Writes a directional field in raw format to a binary file (see directional::RawFieldHeader).
+  // The payload is the memory of rawField as is: the scalar type (double or float) and the layout (column- or row-major) of the file are those of the matrix.
+  // To store a double field in single precision, pass Eigen::MatrixXf(rawField.cast<float>()).
+  // Inputs:
+  //   fileName: The name of the file
+  //   rawField: #F by 3*N in xyzxyz format (N is derived from rawField.cols())
+  // Returns:
+  //   Whether or not the file was written successfully
+  template<typename Scalar, int Options>
+  bool IGL_INLINE write_raw_field_binary(const std::string& fileName,
+                                         const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Options>& rawField)
+  {
+    static_assert(std::is_same<Scalar,double>::value || std::is_same<Scalar,float>::value, "write_raw_field_binary(): the field must be double or float");
+    assert(rawField.cols()%3==0);
+    
+    RawFieldHeader header;
+    header.N = rawField.cols()/3;
+    header.numFaces = rawField.rows();
+    header.scalarType = (std::is_same<Scalar,float>::value ? RawFieldHeader::SCALAR_FLOAT : RawFieldHeader::SCALAR_DOUBLE);
+    header.layout = ((Options & Eigen::RowMajor) ? RawFieldHeader::ROW_MAJOR : RawFieldHeader::COLUMN_MAJOR);
+    
+    std::ofstream f(fileName, std::ios::binary);
+    if (!f.is_open())
+      return false;
+    f.write(reinterpret_cast<const char*>(&header), sizeof(RawFieldHeader));
+    f.write(reinterpret_cast<const char*>(rawField.data()), header.payload_size());
+    f.close();
+    return !f.fail();
+  }
+}
+
+#endif
@@ -3,7 +3,7 @@
 #include <igl/read_triangle_mesh.h>
 #include <igl/per_face_normals.h>
 #include <igl/unproject_onto_mesh.h>
-#include <igl/edge_topology.h>
+#include <directional/MeshTopology.h>
 #include <directional/read_raw_field.h>
 #include <directional/principal_matching.h>
 #include <directional/combing.h>
@@ -17,7 +17,7 @@ Eigen::MatrixXd rawField, combedField, barycenters;
 directional::DirectionalViewer viewer;
 Eigen::VectorXi matching, combedMatching;
 Eigen::VectorXd effort, combedEffort;
-Eigen::MatrixXi EV, FE, EF;
+directional::MeshTopology mesh;
 Eigen::VectorXi singIndices, singVertices;
 bool showCombed=false;
 bool showSingularities=true;
@@ -48,14 +48,14 @@ int main()
   "  1        Toggle raw field/Combed field" << std::endl <<
   igl::readOBJ(TUTORIAL_SHARED_PATH "/lilium.obj", V, F);
   directional::read_raw_field(TUTORIAL_SHARED_PATH "/lilium.rawfield", N, rawField);
-  igl::edge_topology(V, F, EV, FE, EF);
+  mesh.set_mesh(V, F);
   igl::barycenter(V, F, barycenters);
   
   //computing
-  directional::principal_matching(V, F,EV, EF, FE, rawField, matching, effort,singVertices, singIndices);
-  directional::combing(V,F, EV, EF, FE, rawField, matching, combedField);
+  directional::principal_matching(mesh, rawField, matching, effort,singVertices, singIndices);
+  directional::combing(mesh, rawField, matching, combedField);
   //to get the (mostly trivial) matching of the combed field
-  directional::principal_matching(V, F,EV, EF, FE, combedField, combedMatching, combedEffort,singVertices, singIndices);
+  directional::principal_matching(mesh, combedField, combedMatching, combedEffort,singVertices, singIndices);
   
   //Mesh setup
   viewer.set_mesh(V, F);
@@ -0,0 +1,122 @@
+#include <iostream>
+#include <vector>
+#include <complex>
+#include <Eigen/Core>
+#include <igl/readOFF.h>
+#include <igl/local_basis.h>
+#include <igl/edge_topology.h>
+#include <directional/power_field.h>
+#include <directional/polyvector_field.h>
+#include <directional/polyvector_to_raw.h>
+#include <directional/TangentField.h>
+#include "tutorial_shared_path.h"
+
+// Computes the same fields in double and in single precision (Eigen::MatrixXcf, directional::PolyVectorDataf, directional::TangentFieldf),
+// and checks that the single-precision results agree with the double-precision ones up to a relative tolerance.
+
+Eigen::VectorXi constFaces;
+Eigen::MatrixXi F, EV, EF, FE;
+Eigen::MatrixXd V, B1, B2, normals, constVectors;
+Eigen::VectorXd alignWeights;
+
+int N = 4;
+
+// Single precision keeps about 7 significant digits; the solves lose one or two more to the conditioning of the smoothness energy.
+const double tolerance = 1e-4;
+
+bool allPassed = true;
+
+// Relative difference |a-b|/|a| (Frobenius norm)
+double relative_error(const Eigen::MatrixXcd& doubleField, const Eigen::MatrixXcf& floatField)
+{
+  return (doubleField - floatField.cast<std::complex<double> >()).norm() / doubleField.norm();
+}
+
+double relative_error(const Eigen::MatrixXd& doubleField, const Eigen::MatrixXd& floatField)
+{
+  return (doubleField - floatField).norm() / doubleField.norm();
+}
+
+void report(const std::string& name, const double error)
+{
+  bool passed = (error <= tolerance);
+  allPassed = allPassed && passed;
+  std::cout << name << ": relative error " << error << (passed ? " (OK)" : " (FAILED)") << std::endl;
+}
+
+int main()
+{
+  // Load mesh
+  igl::readOFF(TUTORIAL_SHARED_PATH "/fandisk.off", V, F);
+  igl::edge_topology(V, F, EV, FE, EF);
+  igl::local_basis(V, F, B1, B2, normals);
+
+  // Constraining sharp edges, as in Example 302
+  std::vector<int> constFaceslist;
+  std::vector<Eigen::Vector3d> constVectorslist;
+  for (int i=0;i<EF.rows();i++){
+    if (normals.row(EF(i,0)).dot(normals.row(EF(i,1)))<0.5){
+      constFaceslist.push_back(EF(i,0));
+      constFaceslist.push_back(EF(i,1));
+      constVectorslist.push_back((V.row(EV(i,0))-V.row(EV(i,1))).normalized());
+      constVectorslist.push_back((V.row(EV(i,0))-V.row(EV(i,1))).normalized());
+    }
+  }
+
+  constFaces.resize(constFaceslist.size());
+  constVectors.resize(constVectorslist.size(),3);
+  for (int i=0;i<constFaces.size();i++){
+    constFaces(i)=constFaceslist[i];
+    constVectors.row(i)=constVectorslist[i];
+  }
+  alignWeights = Eigen::VectorXd::Constant(constFaces.size(), 1.0);
+
+  std::cout << "Tolerance: " << tolerance << std::endl;
+
+  // Power fields, with hard and with soft alignment
+  Eigen::MatrixXcd powerFieldd;
+  Eigen::MatrixXcf powerFieldf;
+  directional::power_field(V, F, constFaces, constVectors, Eigen::VectorXd::Constant(constFaces.size(),-1.0), N, powerFieldd);
+  directional::power_field(V, F, constFaces, constVectors, Eigen::VectorXd::Constant(constFaces.size(),-1.0), N, powerFieldf);
+  report("Power field (hard)", relative_error(powerFieldd, powerFieldf));
+
+  directional::power_field(V, F, constFaces, constVectors, alignWeights, N, powerFieldd);
+  directional::power_field(V, F, constFaces, constVectors, alignWeights, N, powerFieldf);
+  report("Power field (soft)", relative_error(powerFieldd, powerFieldf));
+
+  // PolyVectors through the precomputed data, which is reused for a second set of weights
+  directional::PolyVectorData pvDatad;
+  directional::PolyVectorDataf pvDataf;
+  pvDatad.constFaces = pvDataf.constFaces = constFaces;
+  pvDatad.constVectors = pvDataf.constVectors = constVectors;
+  pvDatad.wAlignment = pvDataf.wAlignment = Eigen::VectorXd::Constant(constFaces.size(),-1.0);
+  pvDatad.wSmooth = pvDataf.wSmooth = 1.0;
+  pvDatad.wRoSy = pvDataf.wRoSy = 0.0;
+  directional::polyvector_precompute(V, F, EV, EF, B1, B2, N, pvDatad);
+  directional::polyvector_precompute(V, F, EV, EF, B1, B2, N, pvDataf);
+
+  Eigen::MatrixXcd pvFieldd;
+  Eigen::MatrixXcf pvFieldf;
+  directional::polyvector_field(pvDatad, pvFieldd);
+  directional::polyvector_field(pvDataf, pvFieldf);
+  report("PolyVector field (hard)", relative_error(pvFieldd, pvFieldf));
+
+  pvDatad.wRoSy = pvDataf.wRoSy = 1.0;
+  directional::polyvector_field(pvDatad, pvFieldd);
+  directional::polyvector_field(pvDataf, pvFieldf);
+  report("PolyVector field (hard, RoSy weight 1)", relative_error(pvFieldd, pvFieldf));
+
+  // Extracting the vectors into a double and a single-precision tangent field
+  directional::TangentField tangentFieldd;
+  directional::TangentFieldf tangentFieldf;
+  Eigen::VectorXi failedFacesd, failedFacesf;
+  directional::polyvector_to_raw(pvFieldd, N, tangentFieldd, failedFacesd);
+  directional::polyvector_to_raw(pvFieldf, N, tangentFieldf, failedFacesf);
+  Eigen::MatrixXd rawFieldd, rawFieldf;
+  tangentFieldd.get_raw(B1, B2, rawFieldd);
+  tangentFieldf.get_raw(B1, B2, rawFieldf);
+  report("Raw field from PolyVectors", relative_error(rawFieldd, rawFieldf));
+
+  std::cout << (allPassed ? "Single precision agrees with double precision." : "Single precision differs from double precision beyond the tolerance.") << std::endl;
+  return (allPassed ? 0 : 1);
+}